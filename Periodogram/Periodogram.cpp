@@ -25,6 +25,14 @@
  * |widget SpinBox(minimum=1)
  * |preview disable
  *
+ * |param powerOutput[Power Output] Emit the power bins of each transform on an output port.
+ * The output packets have the "POWER_BINS" format accepted by the periodogram inputs,
+ * with the channel "index", "sampleRate", and "centerFreq" in the packet metadata.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ *
  * |param displayRate[Display Rate] How often the plotter updates.
  * |default 10.0
  * |units updates/sec
@@ -60,6 +68,7 @@
  * |option [Flat-top] "flattop"
  * |option [Kaiser] "kaiser"
  * |option [Chebyshev] "chebyshev"
+ * |option [Polyphase Filter Bank] "pfb"
  * |preview disable
  * |tab FFT
  *
@@ -67,6 +76,9 @@
  * <ul>
  * <li>When using the <i>Kaiser</i> window, specify [beta] to use the parameterized Kaiser window.</li>
  * <li>When using the <i>Chebyshev</i> window, specify [atten] to use the Dolph-Chebyshev window with attenuation in dB.</li>
+ * <li>When using the <i>Polyphase Filter Bank</i>, specify [taps] per branch (default 4).
+ * Each transform folds taps times the FFT size in samples through a windowed-sinc prototype filter,
+ * for flat-topped bins with much lower leakage than a windowed FFT of the same size.</li>
  * </ul>
  * |default []
  * |preview disable
@@ -93,13 +105,45 @@
  * |preview disable
  * |tab FFT
  *
+ * |param zoomAnalysis[Zoom Analysis] Re-analyze the zoomed band at a finer resolution.
+ * When enabled, zooming into a fraction of the input band mixes the zoom center to baseband,
+ * low-pass filters and decimates the input, and transforms the decimated band
+ * with the same number of bins. The resolution improves by the decimation factor
+ * without the cost of a larger transform over the entire band.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab FFT
+ *
  * |param autoScale[Auto-Scale] Enable automatic scaling for the vertical axis.
+ * The axis expands as soon as the visible curves leave it,
+ * and shrinks only when the curves span less than half of it.
  * |default false
  * |option [Auto scale] true
  * |option [Use limits] false
  * |preview disable
  * |tab Axis
  *
+ * |param autoRefLevel[Auto Ref Level] Scale the vertical axis from the noise floor of the first channel.
+ * The axis spans the dynamic range from 10% of the range below the noise floor,
+ * so strong carriers do not affect the scale. This takes precedence over auto-scale.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab Axis
+ *
+ * |param noiseFloorPercentile[Noise Floor Percentile] The percentile of the averaged trace used as the noise floor.
+ * The noise floor is estimated per channel from a histogram of the trace.
+ * Changes to the first channel's noise floor are emitted on the noiseFloorChanged signal,
+ * and the noiseFloor(index) call gets the noise floor of any channel.
+ * A low percentile ignores strong carriers that occupy much of the band.
+ * |default 0.5
+ * |widget DoubleSpinBox(minimum=0.01, maximum=0.99, step=0.05, decimals=2)
+ * |preview disable
+ * |tab Axis
+ *
  * |param refLevel[Reference Level] The maximum displayable power level.
  * |default 0.0
  * |units dBfs
@@ -123,6 +167,18 @@
  * |preview disable
  * |widget DoubleSpinBox(minimum=0.0, maximum=1.0, step=0.05, decimals=3)
  *
+ * |param blockAverage[Block Average] Average the exact mean of the last N frames.
+ * The mean is computed over linear power, and replaces the moving average when N is above 1.
+ * |default 0
+ * |widget SpinBox(minimum=0)
+ * |preview disable
+ *
+ * |param holdDecay[Hold Decay] The rate that the max hold falls and the min hold rises.
+ * A rate of 0.0 holds until the hold curve is toggled from the legend.
+ * |default 0.0
+ * |units dB/s
+ * |preview disable
+ *
  * |param enableXAxis[Enable X-Axis] Show or hide the horizontal axis markers.
  * |option [Show] true
  * |option [Hide] false
@@ -143,6 +199,115 @@
  * |preview disable
  * |tab Axis
  *
+ * |param enableSweep[Sweep Mode] Stitch the frames from a retuning radio into a panoramic trace.
+ * Frames are stored by the center frequency from the frequency labels,
+ * replacing the previous frame for the same center, and the stitched
+ * segments span the horizontal axis.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab Sweep
+ *
+ * |param sweepTrim[Sweep Trim] The fraction of each segment's band trimmed from each edge.
+ * Trimming removes the filter roll-off at the band edges,
+ * and segments that still overlap are split halfway through the overlap.
+ * |default 0.1
+ * |widget DoubleSpinBox(minimum=0.0, maximum=0.49, step=0.05, decimals=2)
+ * |preview disable
+ * |tab Sweep
+ *
+ * |param sweepMaxAge[Sweep Max Age] Drop segments that have not been updated for this long.
+ * Zero keeps every segment until the sweep is cleared.
+ * |default 0.0
+ * |units seconds
+ * |preview disable
+ * |tab Sweep
+ *
+ * |param numPeaks[Num Peaks] The maximum number of peaks to mark on each channel.
+ * Peaks are local maxima of the averaged trace above the peak threshold,
+ * refined by parabolic interpolation and emitted on the peaksDetected signal
+ * as a list of dictionaries with channel, freq (Hz), and power (dB) keys.
+ * Zero disables the peak search.
+ * |default 0
+ * |widget SpinBox(minimum=0)
+ * |preview disable
+ * |tab Peaks
+ *
+ * |param peakThreshold[Peak Threshold] The power above the noise floor for a peak.
+ * |default 10.0
+ * |units dB
+ * |preview disable
+ * |tab Peaks
+ *
+ * |param peakSeparation[Peak Separation] The minimum number of bins between peaks.
+ * |default 8
+ * |widget SpinBox(minimum=1)
+ * |preview disable
+ * |tab Peaks
+ *
+ * |param measureBands[Measurement Bands] Bands for channel power measurements.
+ * Specify pairs of [low, high] frequencies in Hz, such as [-5e3, 5e3, 5e3, 15e3].
+ * The first band is the main channel, and the other bands are measured relative to it.
+ * Each band is shaded on the plot, and the measurements signal emits a list of
+ * dictionaries with channel, band, freqLow, freqHigh, power (dB),
+ * acpr (dB relative to the main channel), and obw (occupied bandwidth in Hz) keys.
+ * |default []
+ * |preview disable
+ * |tab Measure
+ *
+ * |param occupiedFraction[Occupied Fraction] The fraction of a band's power within the occupied bandwidth.
+ * |default 0.99
+ * |widget DoubleSpinBox(minimum=0.5, maximum=1.0, step=0.01, decimals=3)
+ * |preview disable
+ * |tab Measure
+ *
+ * |param enablePersistence[Persistence] Draw a persistence view of the first channel under the traces.
+ * Each frame hits a density grid of frequency and power, and the hits fade over the persistence time,
+ * so intermittent signals remain visible under a continuous carrier.
+ * Every captured frame hits the grid, even when the traces update less often.
+ * The grid spans the power range from the reference level down by the dynamic range.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab Persistence
+ *
+ * |param persistenceTime[Persistence Time] The time constant for hits to fade from the persistence view.
+ * |default 1.0
+ * |units seconds
+ * |preview disable
+ * |tab Persistence
+ *
+ * |param crossMode[Cross Spectrum] Compute averaged cross-spectra between pairs of input channels.
+ * The cross-spectra reuse the transforms of each channel from the aligned captures.
+ * Each pair is drawn as a curve, and the crossSpectrum signal emits a dictionary per update
+ * with channelX, channelY, sampleRate, centerFreq, and density (dB), coherence (dB),
+ * and phase (degrees) lists from -fs/2 to +fs/2.
+ * |default ""
+ * |option [Disable] ""
+ * |option [Reference] "REFERENCE"
+ * |option [Adjacent] "ADJACENT"
+ * |preview disable
+ * |tab Cross
+ *
+ * |param crossDisplay[Cross Display] The cross-spectrum value to draw for each pair.
+ * The density is the magnitude of the cross-spectral density,
+ * the coherence is the magnitude-squared coherence in dB,
+ * and the phase of channel X relative to channel Y is drawn in degrees.
+ * |default "DENSITY"
+ * |option [Density] "DENSITY"
+ * |option [Coherence] "COHERENCE"
+ * |option [Phase] "PHASE"
+ * |preview disable
+ * |tab Cross
+ *
+ * |param crossAverage[Cross Average] The number of frames in the cross-spectrum average.
+ * |default 16
+ * |widget SpinBox(minimum=1)
+ * |preview disable
+ * |tab Cross
+ *
  * |param freqLabelId[Freq Label ID] Labels with this ID can be used to set the center frequency.
  * To ignore frequency labels, set this parameter to an empty string.
  * |default "rxFreq"
@@ -167,6 +332,7 @@
  * |mode graphWidget
  * |factory /plotters/periodogram(remoteEnv)
  * |initializer setNumInputs(numInputs)
+ * |initializer enablePowerOutput(powerOutput)
  * |setter setTitle(title)
  * |setter setDisplayRate(displayRate)
  * |setter setSampleRate(sampleRate)
@@ -175,13 +341,31 @@
  * |setter setWindowType(window, windowArgs)
  * |setter setFullScale(fullScale)
  * |setter setFFTMode(fftMode)
+ * |setter enableZoomAnalysis(zoomAnalysis)
  * |setter setAutoScale(autoScale)
+ * |setter enableAutoRefLevel(autoRefLevel)
+ * |setter setNoiseFloorPercentile(noiseFloorPercentile)
  * |setter setReferenceLevel(refLevel)
  * |setter setDynamicRange(dynRange)
  * |setter setAverageFactor(averaging)
+ * |setter setBlockAverage(blockAverage)
+ * |setter setHoldDecay(holdDecay)
  * |setter enableXAxis(enableXAxis)
  * |setter enableYAxis(enableYAxis)
  * |setter setYAxisTitle(yAxisTitle)
+ * |setter enableSweep(enableSweep)
+ * |setter setSweepTrim(sweepTrim)
+ * |setter setSweepMaxAge(sweepMaxAge)
+ * |setter setNumPeaks(numPeaks)
+ * |setter setPeakThreshold(peakThreshold)
+ * |setter setPeakSeparation(peakSeparation)
+ * |setter setMeasurementBands(measureBands)
+ * |setter setOccupiedFraction(occupiedFraction)
+ * |setter enablePersistence(enablePersistence)
+ * |setter setPersistenceTime(persistenceTime)
+ * |setter setCrossMode(crossMode)
+ * |setter setCrossDisplay(crossDisplay)
+ * |setter setCrossAverage(crossAverage)
  * |setter setFreqLabelId(freqLabelId)
  * |setter setRateLabelId(rateLabelId)
  * |setter setStartLabelId(startLabelId)
@@ -206,6 +390,7 @@ public:
 
         //register calls in this topology
         this->registerCall(this, POTHOS_FCN_TUPLE(Periodogram, setNumInputs));
+        this->registerCall(this, POTHOS_FCN_TUPLE(Periodogram, enablePowerOutput));
         this->registerCall(this, POTHOS_FCN_TUPLE(Periodogram, setDisplayRate));
         this->registerCall(this, POTHOS_FCN_TUPLE(Periodogram, setNumFFTBins));
         this->registerCall(this, POTHOS_FCN_TUPLE(Periodogram, setFreqLabelId));
@@ -220,20 +405,43 @@ public:
         this->connect(this, "setWindowType", _display, "setWindowType");
         this->connect(this, "setFullScale", _display, "setFullScale");
         this->connect(this, "setFFTMode", _display, "setFFTMode");
+        this->connect(this, "enableZoomAnalysis", _display, "enableZoomAnalysis");
         this->connect(this, "setReferenceLevel", _display, "setReferenceLevel");
         this->connect(this, "setDynamicRange", _display, "setDynamicRange");
         this->connect(this, "setAutoScale", _display, "setAutoScale");
+        this->connect(this, "enableAutoRefLevel", _display, "enableAutoRefLevel");
+        this->connect(this, "setNoiseFloorPercentile", _display, "setNoiseFloorPercentile");
         this->connect(this, "setAverageFactor", _display, "setAverageFactor");
+        this->connect(this, "setBlockAverage", _display, "setBlockAverage");
+        this->connect(this, "setHoldDecay", _display, "setHoldDecay");
         this->connect(this, "enableXAxis", _display, "enableXAxis");
         this->connect(this, "enableYAxis", _display, "enableYAxis");
         this->connect(this, "setYAxisTitle", _display, "setYAxisTitle");
         this->connect(this, "clearChannels", _display, "clearChannels");
+        this->connect(this, "enableSweep", _display, "enableSweep");
+        this->connect(this, "setSweepTrim", _display, "setSweepTrim");
+        this->connect(this, "setSweepMaxAge", _display, "setSweepMaxAge");
+        this->connect(this, "setNumPeaks", _display, "setNumPeaks");
+        this->connect(this, "setPeakThreshold", _display, "setPeakThreshold");
+        this->connect(this, "setPeakSeparation", _display, "setPeakSeparation");
+        this->connect(this, "setMeasurementBands", _display, "setMeasurementBands");
+        this->connect(this, "setOccupiedFraction", _display, "setOccupiedFraction");
+        this->connect(this, "enablePersistence", _display, "enablePersistence");
+        this->connect(this, "setPersistenceTime", _display, "setPersistenceTime");
+        this->connect(this, "setCrossMode", _display, "setCrossMode");
+        this->connect(this, "setCrossDisplay", _display, "setCrossDisplay");
+        this->connect(this, "setCrossAverage", _display, "setCrossAverage");
         this->connect(_display, "frequencySelected", this, "frequencySelected");
         this->connect(_display, "relativeFrequencySelected", this, "relativeFrequencySelected");
+        this->connect(_display, "imageExported", this, "imageExported");
+        this->connect(_display, "peaksDetected", this, "peaksDetected");
+        this->connect(_display, "noiseFloorChanged", this, "noiseFloorChanged");
+        this->connect(_display, "measurements", this, "measurements");
+        this->connect(_display, "crossSpectrum", this, "crossSpectrum");
 
         //connect to the internal snooper block
         this->connect(this, "setDisplayRate", _trigger, "setEventRate");
-        this->connect(this, "setNumFFTBins", _trigger, "setNumPoints");
+        this->connect(_display, "numPointsChanged", _trigger, "setNumPoints");
 
         //connect stream ports
         this->connect(_trigger, 0, _display, 0);
@@ -262,6 +470,12 @@ public:
         }
     }
 
+    void enablePowerOutput(const bool enable)
+    {
+        _display->enablePowerOutput(enable);
+        if (enable) this->connect(_display, 0, this, 0);
+    }
+
     void setDisplayRate(const double rate)
     {
         _trigger.call("setEventRate", rate);
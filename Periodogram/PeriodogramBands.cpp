@@ -0,0 +1,46 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PeriodogramBands.hpp"
+#include <algorithm> //min/max/upper_bound
+#include <cmath>
+
+void PeriodogramBandMeter::setTrace(const QVector<QPointF> &trace)
+{
+    const size_t N = size_t(trace.size());
+    _prefix.resize(N+1);
+    _prefix[0] = 0.0;
+    for (size_t i = 0; i < N; i++)
+    {
+        _prefix[i+1] = _prefix[i] + std::pow(10.0, trace[int(i)].y()/10);
+    }
+    _xMin = (N == 0)?0.0:trace.front().x();
+    _xStep = (N < 2)?0.0:(trace.back().x() - trace.front().x())/(N-1);
+}
+
+bool PeriodogramBandMeter::measure(const double freqLow, const double freqHigh, const double fraction, PeriodogramBandMeasurement &result) const
+{
+    const size_t N = _prefix.size()-1;
+    if (N < 2 or _xStep <= 0.0) return false;
+
+    //the bins whose centers are within the band
+    const double first = std::ceil((freqLow - _xMin)/_xStep);
+    const double last = std::floor((freqHigh - _xMin)/_xStep);
+    if (last < 0.0 or first > double(N-1) or first > last) return false;
+    const size_t lo = size_t(std::max(first, 0.0));
+    const size_t hi = size_t(std::min(last, double(N-1)));
+
+    const double total = _prefix[hi+1] - _prefix[lo];
+    result.power = 10*std::log10(std::max(total, 1e-30));
+
+    //the bins where the cumulative power crosses the lower and upper tails
+    const double tail = total*(1.0-fraction)/2;
+    const auto begin = _prefix.begin()+lo+1;
+    const auto end = _prefix.begin()+hi+2;
+    const auto loIt = std::lower_bound(begin, end, _prefix[lo] + tail);
+    const auto hiIt = std::lower_bound(begin, end, _prefix[hi+1] - tail);
+    const size_t obwLo = size_t(std::min(loIt, end-1) - begin);
+    const size_t obwHi = size_t(std::min(hiIt, end-1) - begin);
+    result.occupiedBandwidth = (obwHi - obwLo + 1)*_xStep;
+    return true;
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <QVector>
+#include <QPointF>
+#include <vector>
+
+//! Power measurements over a band of the periodogram trace
+struct PeriodogramBandMeasurement
+{
+    double power; //!< integrated power in dB
+    double occupiedBandwidth; //!< in frequency axis units
+};
+
+/*!
+ * Band power meter for periodogram traces.
+ *
+ * The trace is converted to linear power once per frame and accumulated
+ * into prefix sums, so the power of any band is the difference of two sums
+ * and the occupied bandwidth is found with two binary searches.
+ * Any number of bands costs O(bins) per frame in total.
+ */
+class PeriodogramBandMeter
+{
+public:
+    //! Accumulate the linear power of a trace in dB with evenly spaced frequencies
+    void setTrace(const QVector<QPointF> &trace);
+
+    /*!
+     * Measure the band from freqLow to freqHigh in frequency axis units.
+     * The occupied bandwidth contains the fraction of the band's power,
+     * with the remainder split evenly below and above.
+     * Returns false when the band does not overlap the trace.
+     */
+    bool measure(const double freqLow, const double freqHigh, const double fraction, PeriodogramBandMeasurement &result) const;
+
+private:
+    double _xMin, _xStep;
+    std::vector<double> _prefix; //!< _prefix[i] is the sum of the first i bins
+};
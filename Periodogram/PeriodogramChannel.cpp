@@ -4,10 +4,15 @@
 #include "PeriodogramChannel.hpp"
 #include "PothosPlotter.hpp"
 #include "PothosPlotUtils.hpp"
+#include "PothosPlotStyler.hpp"
 #include <qwt_plot_curve.h>
+#include <qwt_plot_marker.h>
+#include <qwt_symbol.h>
 #include <qwt_legend.h>
 #include <cmath>
+#include <chrono>
 #include <algorithm> //min/max
+#include <limits>
 
 template <typename T>
 T movingAvgPowerBinFilter(const T alpha, const T prev, const T curr)
@@ -15,7 +20,25 @@ T movingAvgPowerBinFilter(const T alpha, const T prev, const T curr)
     return 10*std::log((1-alpha)*std::exp(prev/10) + alpha*std::exp(curr/10));
 }
 
-PeriodogramChannel::PeriodogramChannel(const size_t index, PothosPlotter *plot)
+static const float FLOOR_HIST_MIN = -250.0f;
+static const float FLOOR_HIST_STEP = 0.5f;
+static const size_t FLOOR_HIST_SIZE = 600;
+
+static unsigned short floorBucket(const float power)
+{
+    const float bucket = std::floor((power - FLOOR_HIST_MIN)/FLOOR_HIST_STEP);
+    return (unsigned short)(std::min(std::max(bucket, 0.0f), float(FLOOR_HIST_SIZE-1)));
+}
+
+PeriodogramChannel::PeriodogramChannel(const size_t index, PothosPlotter *plot):
+    _plot(plot),
+    _index(index),
+    _rate(0.0),
+    _freq(0.0),
+    _holdDecay(0.0),
+    _lastTime(0.0),
+    _blockSize(0),
+    _blockIndex(0)
 {
     _channelCurve.reset(new QwtPlotCurve(QString("Ch%1").arg(index)));
     _maxHoldCurve.reset(new QwtPlotCurve(QString("Max%1").arg(index)));
@@ -48,27 +71,140 @@ PeriodogramChannel::~PeriodogramChannel(void)
     return;
 }
 
+void PeriodogramChannel::setHoldDecay(const double decay)
+{
+    _holdDecay = decay;
+}
+
+void PeriodogramChannel::setBlockAverage(const size_t numFrames)
+{
+    if (numFrames == _blockSize) return;
+    _blockSize = numFrames;
+    _blockRing.clear();
+}
+
 void PeriodogramChannel::update(const std::valarray<float> &powerBins, const double rate, const double freq, const double factor)
 {
     //scale (0.0 to 1.0) to log10(1.0 to 10.0) = 0.0 to 1.0
     //alpha has a reversed log-scale effect on the averaging
     const float alpha = 1 - float(std::log10(9*factor + 1));
 
+    //the holds decay by the time since the last update
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    const float holdStep = (_lastTime == 0.0)?0.0f:float(_holdDecay*(time-_lastTime));
+    _lastTime = time;
+
+    //averages and holds restart when the bins span a different band
+    if (rate != _rate or freq != _freq)
+    {
+        _channelBuffer.clear();
+        _maxHoldBuffer.clear();
+        _minHoldBuffer.clear();
+        _blockRing.clear();
+        _rate = rate;
+        _freq = freq;
+    }
+
     initBufferSize(powerBins, _channelBuffer);
     initBufferSize(powerBins, _maxHoldBuffer);
     initBufferSize(powerBins, _minHoldBuffer);
 
+    //every bin starts in the lowest bucket and moves as it is averaged
+    if (_floorBucket.size() != powerBins.size())
+    {
+        _floorHist.assign(FLOOR_HIST_SIZE, 0);
+        _floorHist[0] = powerBins.size();
+        _floorBucket.assign(powerBins.size(), 0);
+    }
+
+    const bool block = _blockSize > 1;
+    if (block) this->updateBlockAverage(powerBins);
+
+    //the bounds of each curve are tracked in the same pass for the autoscale
+    const float inf = std::numeric_limits<float>::infinity();
+    float channelLo(inf), channelHi(-inf);
+    float maxHoldLo(inf), maxHoldHi(-inf);
+    float minHoldLo(inf), minHoldHi(-inf);
+
     for (size_t i = 0; i < powerBins.size(); i++)
     {
         auto x = (rate*i)/(powerBins.size()-1) - rate/2 + freq;
-        _channelBuffer[i] = QPointF(x, movingAvgPowerBinFilter<float>(alpha, _channelBuffer[i].y(), powerBins[i]));
-        _maxHoldBuffer[i] = QPointF(x, std::max<float>(_maxHoldBuffer[i].y(), powerBins[i]));
-        _minHoldBuffer[i] = QPointF(x, std::min<float>(_minHoldBuffer[i].y(), powerBins[i]));
+        const float average = block?_blockMean[i]:movingAvgPowerBinFilter<float>(alpha, _channelBuffer[i].y(), powerBins[i]);
+        const float maxHold = std::max<float>(_maxHoldBuffer[i].y()-holdStep, powerBins[i]);
+        const float minHold = std::min<float>(_minHoldBuffer[i].y()+holdStep, powerBins[i]);
+        _channelBuffer[i] = QPointF(x, average);
+        _maxHoldBuffer[i] = QPointF(x, maxHold);
+        _minHoldBuffer[i] = QPointF(x, minHold);
+        channelLo = std::min(channelLo, average);
+        channelHi = std::max(channelHi, average);
+        maxHoldLo = std::min(maxHoldLo, maxHold);
+        maxHoldHi = std::max(maxHoldHi, maxHold);
+        minHoldLo = std::min(minHoldLo, minHold);
+        minHoldHi = std::max(minHoldHi, minHold);
+
+        const auto bucket = floorBucket(float(_channelBuffer[i].y()));
+        if (bucket == _floorBucket[i]) continue;
+        _floorHist[_floorBucket[i]]--;
+        _floorHist[bucket]++;
+        _floorBucket[i] = bucket;
     }
 
     _channelCurve->setSamples(_channelBuffer);
     _maxHoldCurve->setSamples(_maxHoldBuffer);
     _minHoldCurve->setSamples(_minHoldBuffer);
+    _channelBounds = QwtInterval(channelLo, channelHi);
+    _maxHoldBounds = QwtInterval(maxHoldLo, maxHoldHi);
+    _minHoldBounds = QwtInterval(minHoldLo, minHoldHi);
+}
+
+QwtInterval PeriodogramChannel::bounds(void) const
+{
+    QwtInterval bounds;
+    if (_channelCurve->isVisible()) bounds |= _channelBounds;
+    if (_maxHoldCurve->isVisible()) bounds |= _maxHoldBounds;
+    if (_minHoldCurve->isVisible()) bounds |= _minHoldBounds;
+    return bounds;
+}
+
+void PeriodogramChannel::updateBlockAverage(const std::valarray<float> &powerBins)
+{
+    //the ring fills up from an empty state after a reset
+    if (_blockRing.empty() or _blockRing.front().size() != powerBins.size())
+    {
+        _blockRing.clear();
+        _blockIndex = 0;
+        _blockSum.resize(powerBins.size());
+        _blockSum = 0.0;
+    }
+
+    //the linear frame replaces the oldest frame in the running sum
+    std::valarray<float> linear(powerBins.size());
+    for (size_t i = 0; i < powerBins.size(); i++) linear[i] = std::pow(10.0f, powerBins[i]/10);
+    if (_blockRing.size() < _blockSize) _blockRing.push_back(linear);
+    else
+    {
+        for (size_t i = 0; i < linear.size(); i++) _blockSum[i] -= _blockRing[_blockIndex][i];
+        _blockRing[_blockIndex] = linear;
+    }
+    for (size_t i = 0; i < linear.size(); i++) _blockSum[i] += linear[i];
+    _blockIndex = (_blockIndex + 1) % _blockSize;
+
+    //re-sum the ring once per pass so rounding errors do not accumulate
+    if (_blockIndex == 0)
+    {
+        _blockSum = 0.0;
+        for (const auto &frame : _blockRing)
+        {
+            for (size_t i = 0; i < frame.size(); i++) _blockSum[i] += frame[i];
+        }
+    }
+
+    const double scale = 1.0/_blockRing.size();
+    _blockMean.resize(powerBins.size());
+    for (size_t i = 0; i < _blockMean.size(); i++)
+    {
+        _blockMean[i] = float(10*std::log10(std::max(_blockSum[i]*scale, 1e-30)));
+    }
 }
 
 void PeriodogramChannel::clearOnChange(QwtPlotItem *item)
@@ -77,6 +213,39 @@ void PeriodogramChannel::clearOnChange(QwtPlotItem *item)
     if (item == _minHoldCurve.get()) _minHoldBuffer.clear();
 }
 
+float PeriodogramChannel::noiseFloor(const double percentile) const
+{
+    //walk the cumulative histogram up to the percentile
+    const double rank = percentile*_floorBucket.size();
+    size_t count = 0;
+    for (size_t bucket = 0; bucket < _floorHist.size(); bucket++)
+    {
+        count += _floorHist[bucket];
+        if (count > rank) return FLOOR_HIST_MIN + (bucket+0.5f)*FLOOR_HIST_STEP;
+    }
+    return FLOOR_HIST_MIN;
+}
+
+void PeriodogramChannel::updatePeaks(const std::vector<PeriodogramPeak> &peaks)
+{
+    //markers are reused from frame to frame, extra markers are removed
+    _peakMarkers.resize(std::min(_peakMarkers.size(), peaks.size()));
+    while (_peakMarkers.size() < peaks.size())
+    {
+        auto marker = new QwtPlotMarker();
+        marker->setSymbol(new QwtSymbol(QwtSymbol::Diamond, QBrush(pastelize(getDefaultCurveColor(_index))), QPen(Qt::black), QSize(8, 8)));
+        marker->setLabelAlignment(Qt::AlignHCenter | Qt::AlignTop);
+        marker->attach(_plot);
+        _peakMarkers.emplace_back(marker);
+    }
+
+    for (size_t i = 0; i < peaks.size(); i++)
+    {
+        _peakMarkers[i]->setValue(peaks[i].freq, peaks[i].power);
+        _peakMarkers[i]->setLabel(PothosMarkerLabel(QString::number(peaks[i].power, 'f', 1)));
+    }
+}
+
 void PeriodogramChannel::initBufferSize(const std::valarray<float> &powerBins, QVector<QPointF> &buff)
 {
     if (size_t(buff.size()) == powerBins.size()) return;
@@ -3,15 +3,19 @@
 
 #pragma once
 #include <qwt_math.h> //_USE_MATH_DEFINES
+#include <qwt_interval.h>
 #include <QObject>
 #include <QVector>
 #include <QPointF>
 #include <memory>
 #include <valarray>
+#include <vector>
+#include "PeriodogramPeaks.hpp"
 
 class PothosPlotter;
 class QwtPlotCurve;
 class QwtPlotItem;
+class QwtPlotMarker;
 
 class PeriodogramChannel : QObject
 {
@@ -23,16 +27,60 @@ public:
 
     void update(const std::valarray<float> &powerBins, const double rate, const double freq, const double factor);
 
+    //! The rate in dB/s that the max hold falls and the min hold rises, 0.0 holds forever
+    void setHoldDecay(const double decay);
+
+    //! Average the exact mean of the last N frames instead of the moving average, 0 or 1 disables
+    void setBlockAverage(const size_t numFrames);
+
     void clearOnChange(QwtPlotItem *item);
 
+    //! Draw a marker for each peak, an empty list removes the markers
+    void updatePeaks(const std::vector<PeriodogramPeak> &peaks);
+
+    //! The averaged power bins of the channel curve
+    const QVector<QPointF> &samples(void) const
+    {
+        return _channelBuffer;
+    }
+
+    /*!
+     * The noise floor of the averaged trace in dB.
+     * The percentile in (0.0, 1.0) is read from a histogram of the trace
+     * with 0.5 dB buckets, that is updated as the trace is averaged.
+     */
+    float noiseFloor(const double percentile) const;
+
+    /*!
+     * The vertical bounds of the visible curves in dB.
+     * The bounds are tracked while the curves are updated,
+     * and the interval is invalid when no curve is visible.
+     */
+    QwtInterval bounds(void) const;
+
 private:
 
     void initBufferSize(const std::valarray<float> &powerBins, QVector<QPointF> &buff);
+    void updateBlockAverage(const std::valarray<float> &powerBins);
 
+    PothosPlotter *_plot;
+    const size_t _index;
+    double _rate, _freq; //!< frequency span of the buffers
+    double _holdDecay;
+    double _lastTime; //!< the time of the last update for the hold decay
+    size_t _blockSize;
+    std::vector<std::valarray<float>> _blockRing; //!< the last frames in linear power
+    size_t _blockIndex; //!< the next frame to replace in the ring
+    std::valarray<double> _blockSum; //!< running sum of the frames in the ring
+    std::valarray<float> _blockMean; //!< the mean of the ring in dB
     QVector<QPointF> _channelBuffer;
     QVector<QPointF> _maxHoldBuffer;
     QVector<QPointF> _minHoldBuffer;
     std::unique_ptr<QwtPlotCurve> _channelCurve;
     std::unique_ptr<QwtPlotCurve> _maxHoldCurve;
     std::unique_ptr<QwtPlotCurve> _minHoldCurve;
+    std::vector<std::unique_ptr<QwtPlotMarker>> _peakMarkers;
+    std::vector<size_t> _floorHist; //!< the number of bins in each bucket
+    std::vector<unsigned short> _floorBucket; //!< the bucket of each bin
+    QwtInterval _channelBounds, _maxHoldBounds, _minHoldBounds;
 };
@@ -0,0 +1,81 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PeriodogramCross.hpp"
+#include <algorithm> //min/max
+#include <cmath>
+
+PeriodogramCrossSpectrum::PeriodogramCrossSpectrum(void):
+    _numAverages(16),
+    _count(0)
+{
+    return;
+}
+
+void PeriodogramCrossSpectrum::setNumAverages(const size_t numAverages)
+{
+    _numAverages = std::max<size_t>(numAverages, 1);
+}
+
+void PeriodogramCrossSpectrum::reset(void)
+{
+    _count = 0;
+    _sxy.resize(0);
+    _sxx.resize(0);
+    _syy.resize(0);
+}
+
+void PeriodogramCrossSpectrum::update(const CArray &x, const CArray &y)
+{
+    const size_t N = std::min(x.size(), y.size());
+    if (N != _sxy.size()) this->reset();
+    if (_count == 0)
+    {
+        _sxy.resize(N, 0.0);
+        _sxx.resize(N, 0.0);
+        _syy.resize(N, 0.0);
+    }
+
+    //mean of the first frames, then an exponential average
+    _count = std::min(_count+1, _numAverages);
+    const double alpha = 1.0/_count;
+    for (size_t i = 0; i < N; i++)
+    {
+        const std::complex<double> xi(x[i]), yi(y[i]);
+        _sxy[i] += alpha*(xi*std::conj(yi) - _sxy[i]);
+        _sxx[i] += alpha*(std::norm(xi) - _sxx[i]);
+        _syy[i] += alpha*(std::norm(yi) - _syy[i]);
+    }
+}
+
+std::valarray<float> PeriodogramCrossSpectrum::density(const float gain_dB) const
+{
+    std::valarray<float> out(_sxy.size());
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        out[i] = float(10*std::log10(std::max(std::abs(_sxy[reorder(i)]), 1e-20))) - gain_dB;
+    }
+    return out;
+}
+
+std::valarray<float> PeriodogramCrossSpectrum::coherence(void) const
+{
+    std::valarray<float> out(_sxy.size());
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        const size_t k = reorder(i);
+        const double coh = std::norm(_sxy[k])/std::max(_sxx[k]*_syy[k], 1e-40);
+        out[i] = float(10*std::log10(std::max(std::min(coh, 1.0), 1e-20)));
+    }
+    return out;
+}
+
+std::valarray<float> PeriodogramCrossSpectrum::phase(void) const
+{
+    std::valarray<float> out(_sxy.size());
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        out[i] = float(std::arg(_sxy[reorder(i)])*180/M_PI);
+    }
+    return out;
+}
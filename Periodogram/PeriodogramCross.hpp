@@ -0,0 +1,50 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include "PothosPlotterFFTUtils.hpp"
+#include <valarray>
+#include <complex>
+
+/*!
+ * Averaged cross-spectrum between a pair of channels.
+ *
+ * The transforms of both channels from the same capture are accumulated
+ * into the cross-spectral density and both auto-spectral densities with an
+ * exponential average over the number of averages. The average starts as
+ * an exact mean until that many frames have been accumulated.
+ */
+class PeriodogramCrossSpectrum
+{
+public:
+    PeriodogramCrossSpectrum(void);
+
+    //! Set the number of frames in the average
+    void setNumAverages(const size_t numAverages);
+
+    //! Forget the accumulated spectra
+    void reset(void);
+
+    //! Accumulate a pair of transforms in natural order from the same capture
+    void update(const CArray &x, const CArray &y);
+
+    //! The magnitude of the cross-spectral density in dB, reordered from -fs/2 to +fs/2
+    std::valarray<float> density(const float gain_dB) const;
+
+    //! The magnitude-squared coherence in dB, reordered from -fs/2 to +fs/2
+    std::valarray<float> coherence(void) const;
+
+    //! The phase of x relative to y in degrees, reordered from -fs/2 to +fs/2
+    std::valarray<float> phase(void) const;
+
+private:
+    size_t reorder(const size_t i) const
+    {
+        return (i + _sxy.size()/2) % _sxy.size();
+    }
+
+    size_t _numAverages;
+    size_t _count;
+    std::valarray<std::complex<double>> _sxy;
+    std::valarray<double> _sxx, _syy;
+};
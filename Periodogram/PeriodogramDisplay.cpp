@@ -3,14 +3,22 @@
 
 #include "PeriodogramDisplay.hpp"
 #include "PeriodogramChannel.hpp"
+#include "PeriodogramPersistence.hpp"
 #include "PothosPlotter.hpp"
+#include "PothosPlotUtils.hpp"
 #include <QResizeEvent>
+#include <QImage>
+#include <QPainter>
 #include <qwt_plot.h>
 #include <qwt_plot_grid.h>
 #include <qwt_legend.h>
 #include <qwt_plot_zoomer.h>
+#include <qwt_plot_renderer.h>
+#include <qwt_plot_zoneitem.h>
+#include <qwt_plot_curve.h>
 #include <QHBoxLayout>
 #include <algorithm> //min/max
+#include <limits>
 
 PeriodogramDisplay::PeriodogramDisplay(void):
     _mainPlot(new PothosPlotter(this, POTHOS_PLOTTER_GRID | POTHOS_PLOTTER_ZOOM)),
@@ -25,9 +33,29 @@ PeriodogramDisplay::PeriodogramDisplay(void):
     _freqLabelId("rxFreq"),
     _rateLabelId("rxRate"),
     _averageFactor(0.0),
+    _holdDecay(0.0),
+    _blockAverage(0),
     _fullScale(1.0),
     _fftModeComplex(true),
-    _fftModeAutomatic(true)
+    _fftModeAutomatic(true),
+    _zoomAnalysis(false),
+    _lastNumPoints(0),
+    _sweepEnabled(false),
+    _sweepTrim(0.1),
+    _sweepMaxAge(0.0),
+    _sweepLow(0.0),
+    _sweepHigh(0.0),
+    _noiseFloorPercentile(0.5),
+    _autoRefLevel(false),
+    _axisNoiseFloor(std::numeric_limits<double>::quiet_NaN()),
+    _lastNoiseFloor(std::numeric_limits<float>::quiet_NaN()),
+    _occupiedFraction(0.99),
+    _persistenceEnabled(false),
+    _persistence(new PeriodogramPersistenceItem()),
+    _powerOutput(false),
+    _crossDisplay("DENSITY"),
+    _crossAverage(16),
+    _crossNumChannels(0)
 {
     //setup block
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, widget));
@@ -41,6 +69,24 @@ PeriodogramDisplay::PeriodogramDisplay(void):
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setReferenceLevel));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setDynamicRange));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setAutoScale));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, enableZoomAnalysis));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, enableSweep));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setSweepTrim));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setSweepMaxAge));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setNumPeaks));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setPeakThreshold));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setPeakSeparation));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setNoiseFloorPercentile));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, noiseFloor));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, enableAutoRefLevel));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setMeasurementBands));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setOccupiedFraction));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, enablePersistence));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setPersistenceTime));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setCrossMode));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setCrossDisplay));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setCrossAverage));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, enablePowerOutput));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, title));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, sampleRate));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, centerFrequency));
@@ -49,16 +95,26 @@ PeriodogramDisplay::PeriodogramDisplay(void):
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, dynamicRange));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, autoScale));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setAverageFactor));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setHoldDecay));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setBlockAverage));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, enableXAxis));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, enableYAxis));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setYAxisTitle));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setFreqLabelId));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, setRateLabelId));
     this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, clearChannels));
+    this->registerCall(this, POTHOS_FCN_TUPLE(PeriodogramDisplay, exportImage));
     this->registerSlot("clearChannels");
     this->registerSignal("frequencySelected");
     this->registerSignal("relativeFrequencySelected");
+    this->registerSignal("imageExported");
+    this->registerSignal("numPointsChanged");
+    this->registerSignal("peaksDetected");
+    this->registerSignal("noiseFloorChanged");
+    this->registerSignal("measurements");
+    this->registerSignal("crossSpectrum");
     this->setupInput(0);
+    this->setupOutput(0);
 
     //layout
     auto layout = new QHBoxLayout(this);
@@ -76,6 +132,12 @@ PeriodogramDisplay::PeriodogramDisplay(void):
         connect(legend, SIGNAL(checked(const QVariant &, bool, int)), this, SLOT(handleLegendChecked(const QVariant &, bool, int)));
         _mainPlot->insertLegend(legend);
     }
+
+    //setup persistence view
+    {
+        _persistence->attach(_mainPlot);
+        _persistence->setVisible(false);
+    }
 }
 
 PeriodogramDisplay::~PeriodogramDisplay(void)
@@ -83,6 +145,11 @@ PeriodogramDisplay::~PeriodogramDisplay(void)
     return;
 }
 
+QwtPlotZoomer *PeriodogramDisplay::zoomer(void) const
+{
+    return _mainPlot->zoomer();
+}
+
 void PeriodogramDisplay::setTitle(const QString &title)
 {
     QMetaObject::invokeMethod(_mainPlot, "setTitle", Qt::QueuedConnection, Q_ARG(QString, title));
@@ -144,10 +211,137 @@ void PeriodogramDisplay::setAutoScale(const bool autoScale)
     QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
 }
 
+void PeriodogramDisplay::enableZoomAnalysis(const bool enable)
+{
+    _zoomAnalysis = enable;
+    QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+}
+
+void PeriodogramDisplay::enableSweep(const bool enable)
+{
+    _sweepEnabled = enable;
+    this->clearChannels();
+}
+
+void PeriodogramDisplay::setSweepTrim(const double trim)
+{
+    if (trim < 0.0 or trim >= 0.5) throw Pothos::RangeException(
+        "PeriodogramDisplay::setSweepTrim("+std::to_string(trim)+")",
+        "trim must be in [0.0, 0.5)");
+    _sweepTrim = trim;
+}
+
+void PeriodogramDisplay::setSweepMaxAge(const double maxAge)
+{
+    _sweepMaxAge = maxAge;
+}
+
+void PeriodogramDisplay::setNumPeaks(const size_t numPeaks)
+{
+    _peakFinder.setNumPeaks(numPeaks);
+}
+
+void PeriodogramDisplay::setPeakThreshold(const double threshold)
+{
+    _peakFinder.setThreshold(threshold);
+}
+
+void PeriodogramDisplay::setPeakSeparation(const size_t numBins)
+{
+    _peakFinder.setMinSeparation(numBins);
+}
+
+void PeriodogramDisplay::setNoiseFloorPercentile(const double percentile)
+{
+    if (percentile <= 0.0 or percentile >= 1.0) throw Pothos::RangeException(
+        "PeriodogramDisplay::setNoiseFloorPercentile("+std::to_string(percentile)+")",
+        "percentile must be in (0.0, 1.0)");
+    _noiseFloorPercentile = percentile;
+}
+
+double PeriodogramDisplay::noiseFloor(const size_t index) const
+{
+    std::lock_guard<std::mutex> lock(_noiseFloorMutex);
+    const auto it = _noiseFloors.find(index);
+    if (it == _noiseFloors.end()) return std::numeric_limits<double>::quiet_NaN();
+    return it->second;
+}
+
+void PeriodogramDisplay::enableAutoRefLevel(const bool enable)
+{
+    _autoRefLevel = enable;
+    QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+}
+
+void PeriodogramDisplay::setMeasurementBands(const std::vector<double> &bands)
+{
+    if (bands.size() % 2 != 0) throw Pothos::InvalidArgumentException(
+        "PeriodogramDisplay::setMeasurementBands()", "bands must be pairs of [low, high]");
+    for (size_t i = 0; i < bands.size(); i += 2)
+    {
+        if (bands[i] < bands[i+1]) continue;
+        throw Pothos::InvalidArgumentException("PeriodogramDisplay::setMeasurementBands()",
+            "band "+std::to_string(i/2)+" low must be less than high");
+    }
+    _measureBands = bands;
+    QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+}
+
+void PeriodogramDisplay::setOccupiedFraction(const double fraction)
+{
+    if (fraction <= 0.0 or fraction > 1.0) throw Pothos::RangeException(
+        "PeriodogramDisplay::setOccupiedFraction("+std::to_string(fraction)+")",
+        "fraction must be in (0.0, 1.0]");
+    _occupiedFraction = fraction;
+}
+
+void PeriodogramDisplay::enablePersistence(const bool enable)
+{
+    _persistenceEnabled = enable;
+    _persistence->clear();
+    QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+}
+
+void PeriodogramDisplay::setPersistenceTime(const double seconds)
+{
+    _persistence->setDecayTime(seconds);
+}
+
+void PeriodogramDisplay::setCrossMode(const std::string &mode)
+{
+    if (mode != "" and mode != "REFERENCE" and mode != "ADJACENT") throw Pothos::InvalidArgumentException(
+        "PeriodogramDisplay::setCrossMode("+mode+")", "unknown cross mode");
+    _crossMode = mode;
+    _crossFrames.clear();
+    _crossSpectra.clear();
+    _crossNumChannels = 0;
+    this->clearChannels();
+}
+
+void PeriodogramDisplay::setCrossDisplay(const std::string &display)
+{
+    if (display != "DENSITY" and display != "COHERENCE" and display != "PHASE") throw Pothos::InvalidArgumentException(
+        "PeriodogramDisplay::setCrossDisplay("+display+")", "unknown cross display");
+    _crossDisplay = display;
+}
+
+void PeriodogramDisplay::setCrossAverage(const size_t numFrames)
+{
+    _crossAverage = numFrames;
+}
+
+void PeriodogramDisplay::enablePowerOutput(const bool enable)
+{
+    _powerOutput = enable;
+}
+
 void PeriodogramDisplay::handleUpdateAxis(void)
 {
+    //in sweep mode the axis spans the stitched segments
+    const bool sweep = _sweepEnabled and _sweepHigh > _sweepLow;
+
     QString axisTitle("Hz");
-    double factor = std::max(_sampleRate, _centerFreq);
+    double factor = sweep?std::max(_sweepHigh-_sweepLow, _sweepHigh):std::max(_sampleRate, _centerFreq);
     if (factor >= 2e9)
     {
         factor = 1e9;
@@ -169,11 +363,40 @@ void PeriodogramDisplay::handleUpdateAxis(void)
     _sampleRateWoAxisUnits = _sampleRate/factor;
     _centerFreqWoAxisUnits = _centerFreq/factor;
     const qreal freqLow = _fftModeComplex?(_centerFreqWoAxisUnits-_sampleRateWoAxisUnits/2):0.0;
-    _mainPlot->setAxisScale(QwtPlot::xBottom, freqLow, _centerFreqWoAxisUnits+_sampleRateWoAxisUnits/2);
-    _mainPlot->setAxisScale(QwtPlot::yLeft, _refLevel-_dynRange, _refLevel);
+    if (sweep) _mainPlot->setAxisScale(QwtPlot::xBottom, _sweepLow/factor, _sweepHigh/factor);
+    else _mainPlot->setAxisScale(QwtPlot::xBottom, freqLow, _centerFreqWoAxisUnits+_sampleRateWoAxisUnits/2);
+    const double yLow = (_autoRefLevel and not std::isnan(_axisNoiseFloor))?(_axisNoiseFloor-0.1*_dynRange):(_refLevel-_dynRange);
+    _mainPlot->setAxisScale(QwtPlot::yLeft, yLow, yLow+_dynRange);
     _mainPlot->updateAxes(); //update after axis changes
     _mainPlot->zoomer()->setZoomBase(); //record current axis settings
     this->handleZoomed(_mainPlot->zoomer()->zoomBase()); //reload
+    _persistence->setFreqAxisScale(_sampleRateWoAxisUnits/_sampleRate);
+    _persistence->setVisible(_persistenceEnabled and not _sweepEnabled);
+    this->updateBandZones();
+}
+
+void PeriodogramDisplay::updateBandZones(void)
+{
+    //one shaded zone per band, the main channel is drawn darker
+    const size_t numBands = _measureBands.size()/2;
+    _bandZones.resize(std::min(_bandZones.size(), numBands));
+    while (_bandZones.size() < numBands)
+    {
+        auto zone = new QwtPlotZoneItem();
+        zone->setOrientation(Qt::Vertical);
+        QColor color(_bandZones.empty()?Qt::darkCyan:Qt::gray);
+        color.setAlpha(_bandZones.empty()?60:40);
+        zone->setBrush(QBrush(color));
+        zone->attach(_mainPlot);
+        _bandZones.emplace_back(zone);
+    }
+
+    const double toAxis = _sampleRateWoAxisUnits/_sampleRate;
+    for (size_t i = 0; i < numBands; i++)
+    {
+        _bandZones[i]->setInterval(_measureBands[2*i]*toAxis, _measureBands[2*i+1]*toAxis);
+    }
+    _mainPlot->replot();
 }
 
 QVariant PeriodogramDisplay::saveState(void) const
@@ -194,15 +417,62 @@ void PeriodogramDisplay::restoreState(const QVariant &state)
 void PeriodogramDisplay::handleZoomed(const QRectF &rect)
 {
     //when zoomed all the way out, return to autoscale
-    if (rect == _mainPlot->zoomer()->zoomBase() and _autoScale)
+    if (rect == _mainPlot->zoomer()->zoomBase() and _autoScale and not _autoRefLevel)
+    {
+        _autoScaler.reset();
+        this->updateAutoScale();
+    }
+
+    //the zoomed band in Hz, limited to the input band
+    const auto base = _mainPlot->zoomer()->zoomBase();
+    const double toHz = _sampleRate/_sampleRateWoAxisUnits;
+    const double lo = std::max(rect.left(), base.left())*toHz;
+    const double hi = std::min(rect.right(), base.right())*toHz;
+
+    //re-analyze the zoomed band when it is a fraction of the input band
+    const size_t decim = FrequencyZoom::decimationFor(_sampleRate, hi-lo);
+    if (not _zoomAnalysis or _sweepEnabled or rect == base or decim < 2)
     {
-        _mainPlot->setAxisAutoScale(QwtPlot::yLeft);
+        return this->setZoomAnalysis(std::shared_ptr<FrequencyZoom>());
     }
+
+    std::shared_ptr<FrequencyZoom> zoom(new FrequencyZoom());
+    zoom->configure((lo+hi)/2 - _centerFreq, _sampleRate, decim);
+    this->setZoomAnalysis(zoom);
+}
+
+void PeriodogramDisplay::setZoomAnalysis(const std::shared_ptr<FrequencyZoom> &zoom)
+{
+    if (not zoom and not std::atomic_load(&_freqZoom)) return;
+    std::atomic_store(&_freqZoom, zoom);
+}
+
+size_t PeriodogramDisplay::numInputPoints(const std::shared_ptr<FrequencyZoom> &zoom) const
+{
+    const size_t numInput = _fftPowerSpectrum.inputSize(_numBins);
+    return zoom?zoom->inputSize(numInput):numInput;
 }
 
 void PeriodogramDisplay::handleClearChannels(void)
 {
     _curves.clear();
+    _crossCurves.clear();
+    _crossBounds.clear();
+    _autoScaler.reset();
+    _persistence->clear();
+    {
+        std::lock_guard<std::mutex> lock(_noiseFloorMutex);
+        _noiseFloors.clear();
+    }
+
+    //the axis returns to the input band once the sweep is cleared
+    {
+        std::lock_guard<std::mutex> lock(_sweepMutex);
+        _sweeps.clear();
+    }
+    const bool hadSweep = _sweepHigh > _sweepLow;
+    _sweepLow = _sweepHigh = 0.0;
+    if (hadSweep) this->handleUpdateAxis();
 }
 
 QString PeriodogramDisplay::title(void) const
@@ -243,3 +513,45 @@ void PeriodogramDisplay::handleLegendChecked(const QVariant &itemInfo, bool on,
     item->setVisible(on);
     _mainPlot->replot();
 }
+
+void PeriodogramDisplay::exportImage(const std::string &path, const int width, const int height)
+{
+    if (path.empty()) throw Pothos::InvalidArgumentException("PeriodogramDisplay::exportImage()", "empty path");
+    if (width <= 0 or height <= 0) throw Pothos::RangeException("PeriodogramDisplay::exportImage()", "size must be positive");
+    QMetaObject::invokeMethod(this, "handleExportImage", Qt::QueuedConnection,
+        Q_ARG(QString, QString::fromStdString(path)), Q_ARG(int, width), Q_ARG(int, height));
+}
+
+void PeriodogramDisplay::handleExportImage(const QString &path, const int width, const int height)
+{
+    bool ok = false;
+
+    //one row per channel, shorter channels are padded with NaN
+    if (path.endsWith(".npy", Qt::CaseInsensitive))
+    {
+        size_t numCols = 0;
+        for (const auto &c : _curves) numCols = std::max(numCols, size_t(c.second->samples().size()));
+        std::vector<float> rows(_curves.size()*numCols, std::numeric_limits<float>::quiet_NaN());
+        size_t row = 0;
+        for (const auto &c : _curves)
+        {
+            const auto &samples = c.second->samples();
+            for (int i = 0; i < samples.size(); i++) rows[row*numCols+i] = float(samples[i].y());
+            row++;
+        }
+        ok = writeNumpyFloat32(path, _curves.size(), numCols, rows.data());
+    }
+
+    //render the plot and its current zoom offscreen
+    else
+    {
+        QImage image(width, height, QImage::Format_ARGB32);
+        image.fill(Qt::white);
+        QPainter painter(&image);
+        QwtPlotRenderer renderer;
+        renderer.render(_mainPlot, &painter, QRectF(0, 0, width, height));
+        painter.end();
+        ok = image.save(path);
+    }
+    this->emitSignal("imageExported", path.toStdString(), ok);
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 #include <qwt_math.h> //_USE_MATH_DEFINES
+#include <qwt_interval.h>
 #include <Pothos/Framework.hpp>
 #include <QVariant>
 #include <QWidget>
@@ -10,11 +11,20 @@
 #include <map>
 #include <vector>
 #include <atomic>
+#include <mutex>
 #include "PothosPlotterFFTUtils.hpp"
+#include "PothosSweepStitcher.hpp"
+#include "PothosAutoScaler.hpp"
+#include "PeriodogramPeaks.hpp"
+#include "PeriodogramBands.hpp"
+#include "PeriodogramCross.hpp"
 
 class PothosPlotter;
 class QwtPlotCurve;
+class QwtPlotZoneItem;
+class QwtPlotZoomer;
 class PeriodogramChannel;
+class PeriodogramPersistenceItem;
 
 class PeriodogramDisplay : public QWidget, public Pothos::Block
 {
@@ -30,6 +40,9 @@ public:
         return this;
     }
 
+    //! The zoomer of the plot, used to link the frequency axis with another plotter
+    QwtPlotZoomer *zoomer(void) const;
+
     //! set the plotter's title
     void setTitle(const QString &title);
 
@@ -52,6 +65,97 @@ public:
     void setDynamicRange(const double dynRange);
     void setAutoScale(const bool autoScale);
 
+    /*!
+     * Re-analyze the zoomed band at a finer resolution.
+     * When the zoom covers a fraction of the input band, the input is mixed
+     * to the zoom center, decimated, and transformed at the same FFT size.
+     */
+    void enableZoomAnalysis(const bool enable);
+
+    /*!
+     * Stitch the frames from a retuning radio into a panoramic trace.
+     * Frames are stored by the center frequency from the frequency labels,
+     * and the horizontal axis spans every stored segment.
+     */
+    void enableSweep(const bool enable);
+
+    //! The fraction of each segment's band trimmed from each edge
+    void setSweepTrim(const double trim);
+
+    //! Drop sweep segments that are not updated for this many seconds (0 keeps them)
+    void setSweepMaxAge(const double maxAge);
+
+    /*!
+     * Search each channel's averaged trace for the strongest peaks.
+     * Peaks are marked on the plot and emitted on the peaksDetected signal.
+     * A value of 0 disables the peak search.
+     */
+    void setNumPeaks(const size_t numPeaks);
+
+    //! The peak threshold in dB above the median of the trace
+    void setPeakThreshold(const double threshold);
+
+    //! The minimum number of bins between peaks
+    void setPeakSeparation(const size_t numBins);
+
+    /*!
+     * The percentile of the averaged trace used as the noise floor.
+     * A low percentile ignores strong carriers that occupy much of the band.
+     */
+    void setNoiseFloorPercentile(const double percentile);
+
+    //! The noise floor of a channel in dB, NaN before the first update
+    double noiseFloor(const size_t index) const;
+
+    /*!
+     * Scale the vertical axis from the noise floor of the first channel.
+     * The axis spans the dynamic range from 10% of the range below the
+     * noise floor, so that strong carriers do not affect the scale.
+     */
+    void enableAutoRefLevel(const bool enable);
+
+    /*!
+     * Measure power in bands of the averaged trace.
+     * The bands are pairs of [low, high] frequencies in Hz.
+     * The first band is the main channel, and the power of the other bands
+     * is also reported relative to the main channel (ACPR).
+     * Measurements are emitted on the measurements signal.
+     */
+    void setMeasurementBands(const std::vector<double> &bands);
+
+    //! The fraction of a band's power within the occupied bandwidth
+    void setOccupiedFraction(const double fraction);
+
+    /*!
+     * Draw a persistence view of the first channel under the traces.
+     * Every frame hits a density grid that spans the reference level range,
+     * including frames that are captured faster than the display updates.
+     */
+    void enablePersistence(const bool enable);
+
+    //! The time constant in seconds for hits to fade from the persistence view
+    void setPersistenceTime(const double seconds);
+
+    /*!
+     * Compute averaged cross-spectra between pairs of channels.
+     * The mode "REFERENCE" pairs the first channel with each other channel,
+     * "ADJACENT" pairs each channel with the next, and "" disables the cross-spectra.
+     */
+    void setCrossMode(const std::string &mode);
+
+    //! The cross-spectrum curve: "DENSITY", "COHERENCE", or "PHASE"
+    void setCrossDisplay(const std::string &display);
+
+    //! The number of frames in the cross-spectrum average
+    void setCrossAverage(const size_t numFrames);
+
+    /*!
+     * Emit the power bins of each transform on output port 0.
+     * The packets have the "POWER_BINS" format accepted on the inputs,
+     * with the "index", "sampleRate", and "centerFreq" in the metadata.
+     */
+    void enablePowerOutput(const bool enable);
+
     QString title(void) const;
 
     double sampleRate(void) const
@@ -88,6 +192,13 @@ public:
     void enableYAxis(const bool enb);
     void setYAxisTitle(const QString &title);
 
+    /*!
+     * Export the plot offscreen at the given resolution.
+     * Paths ending in .npy export the power bins in dB with one row per channel,
+     * otherwise the image format is determined by the file extension.
+     */
+    void exportImage(const std::string &path, const int width, const int height);
+
     void clearChannels(void)
     {
         QMetaObject::invokeMethod(this, "handleClearChannels", Qt::QueuedConnection);
@@ -111,6 +222,21 @@ public:
         _averageFactor = factor;
     }
 
+    //! The rate in dB/s that the max hold falls and the min hold rises, 0.0 holds forever
+    void setHoldDecay(const double decay)
+    {
+        if (decay < 0.0) throw Pothos::RangeException(
+            "Periodogram::setHoldDecay("+std::to_string(decay)+")",
+            "decay must be non-negative");
+        _holdDecay = decay;
+    }
+
+    //! Average the exact mean of the last N frames instead of the moving average, 0 or 1 disables
+    void setBlockAverage(const size_t numFrames)
+    {
+        _blockAverage = numFrames;
+    }
+
     void work(void);
 
     //allow for standard resize controls with the default size policy
@@ -131,13 +257,27 @@ public slots:
 
 private slots:
     void handlePickerSelected(const QPointF &);
-    void handlePowerBins(const int index, const std::valarray<float> &bins);
+    void handlePowerBins(const int index, const std::valarray<float> &bins, const double rate, const double freq);
     void handleUpdateAxis(void);
     void handleZoomed(const QRectF &rect);
     void handleClearChannels(void);
     void handleLegendChecked(const QVariant &, bool, int);
+    void handleExportImage(const QString &path, const int width, const int height);
+    void handleCrossBins(const int channelX, const int channelY, const std::valarray<float> &bins, const double rate, const double freq);
 
 private:
+    void setZoomAnalysis(const std::shared_ptr<FrequencyZoom> &zoom);
+    size_t numInputPoints(const std::shared_ptr<FrequencyZoom> &zoom) const;
+    void updateSweep(const int index, const std::valarray<float> &powerBins, const double rate, const double freq);
+    void handleSweepBins(const int index);
+    float updateNoiseFloor(const int index);
+    void detectPeaks(const int index, const float noiseFloor);
+    void measureBands(const int index);
+    void updateBandZones(void);
+    void updateCrossSpectra(const int index, const CArray &fftBins, const double rate, const double freq);
+    std::valarray<float> transformBins(CArray &fftBins, const int index, const double rate, const double freq);
+    void updateAutoScale(void);
+
     PothosPlotter *_mainPlot;
     FFTPowerSpectrum _fftPowerSpectrum;
     double _sampleRate;
@@ -148,14 +288,64 @@ private:
     double _refLevel;
     double _dynRange;
     bool _autoScale;
+    PothosAutoScaler _autoScaler; //!< only used by the GUI thread
     std::string _freqLabelId;
     std::string _rateLabelId;
     double _averageFactor;
+    double _holdDecay;
+    size_t _blockAverage;
     double _fullScale;
     bool _fftModeComplex;
     bool _fftModeAutomatic;
+    bool _zoomAnalysis;
+    std::shared_ptr<FrequencyZoom> _freqZoom; //accessed with std::atomic_load/store
+    std::vector<std::complex<float>> _zoomSamps;
+    size_t _lastNumPoints; //!< the last capture size emitted to the trigger
+    bool _sweepEnabled;
+    double _sweepTrim;
+    double _sweepMaxAge;
+    double _sweepLow, _sweepHigh; //!< the stitched band of the first channel
+    PeriodogramPeakFinder _peakFinder; //!< only used by the GUI thread
+    double _noiseFloorPercentile;
+    bool _autoRefLevel;
+    double _axisNoiseFloor; //!< the noise floor that set the axis, NaN when unset
+    float _lastNoiseFloor; //!< the last noise floor emitted for the first channel
+    mutable std::mutex _noiseFloorMutex;
+    std::map<size_t, double> _noiseFloors;
+    std::vector<double> _measureBands;
+    double _occupiedFraction;
+    PeriodogramBandMeter _bandMeter; //!< only used by the GUI thread
+    std::vector<std::unique_ptr<QwtPlotZoneItem>> _bandZones;
+    bool _persistenceEnabled;
+    std::unique_ptr<PeriodogramPersistenceItem> _persistence;
+    bool _powerOutput;
+
+    //cross-spectra, only used by the work thread
+    struct CrossFrame
+    {
+        CrossFrame(void): seq(0){}
+        CArray bins;
+        size_t seq; //!< the number of frames from the channel
+    };
+    struct CrossState
+    {
+        CrossState(void): seqX(0), seqY(0), rate(0.0), freq(0.0){}
+        PeriodogramCrossSpectrum spectrum;
+        size_t seqX, seqY; //!< the frames used in the last update
+        double rate, freq;
+    };
+    std::string _crossMode;
+    std::string _crossDisplay;
+    size_t _crossAverage;
+    size_t _crossNumChannels;
+    std::map<size_t, CrossFrame> _crossFrames;
+    std::map<std::pair<size_t, size_t>, CrossState> _crossSpectra;
+    std::map<std::pair<size_t, size_t>, std::unique_ptr<QwtPlotCurve>> _crossCurves; //!< only used by the GUI thread
+    std::map<std::pair<size_t, size_t>, QwtInterval> _crossBounds; //!< only used by the GUI thread
 
     //per-port data structs
     std::map<size_t, std::unique_ptr<PeriodogramChannel>> _curves;
     std::map<size_t, std::unique_ptr<std::atomic<size_t>>> _queueDepth;
+    std::mutex _sweepMutex;
+    std::map<size_t, PothosSweepStitcher> _sweeps; //!< fed by the work thread, stitched by the GUI thread
 };
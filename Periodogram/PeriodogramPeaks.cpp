@@ -0,0 +1,78 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PeriodogramPeaks.hpp"
+#include <algorithm> //min/max/heap
+
+PeriodogramPeakFinder::PeriodogramPeakFinder(void):
+    _numPeaks(0),
+    _threshold(10.0f),
+    _minSeparation(8)
+{
+    return;
+}
+
+void PeriodogramPeakFinder::setNumPeaks(const size_t numPeaks)
+{
+    _numPeaks = numPeaks;
+}
+
+void PeriodogramPeakFinder::setThreshold(const double threshold)
+{
+    _threshold = float(threshold);
+}
+
+void PeriodogramPeakFinder::setMinSeparation(const size_t numBins)
+{
+    _minSeparation = numBins;
+}
+
+const std::vector<PeriodogramPeak> &PeriodogramPeakFinder::find(const QVector<QPointF> &trace, const float noiseFloor)
+{
+    _peaks.clear();
+    const size_t N = size_t(trace.size());
+    if (_numPeaks == 0 or N < 3) return _peaks;
+
+    //contiguous power values for the scans below
+    _power.resize(N);
+    for (size_t i = 0; i < N; i++) _power[i] = float(trace[int(i)].y());
+    const float level = noiseFloor + _threshold;
+
+    //local maxima above the threshold, plateaus count once on the rising edge
+    _candidates.clear();
+    const float *p = _power.data();
+    for (size_t i = 1; i+1 < N; i++)
+    {
+        if (p[i] > level and p[i] > p[i-1] and p[i] >= p[i+1]) _candidates.push_back(i);
+    }
+
+    //accept the strongest candidates that are not too close to an accepted peak
+    const auto byPower = [p](const size_t a, const size_t b){return p[a] < p[b];};
+    std::make_heap(_candidates.begin(), _candidates.end(), byPower);
+    auto end = _candidates.end();
+    while (_peaks.size() < _numPeaks and end != _candidates.begin())
+    {
+        std::pop_heap(_candidates.begin(), end, byPower);
+        const size_t i = *(--end);
+
+        bool separated = true;
+        for (const auto &peak : _peaks)
+        {
+            const size_t distance = (peak.bin > i)?(peak.bin-i):(i-peak.bin);
+            if (distance < _minSeparation) separated = false;
+        }
+        if (not separated) continue;
+
+        //parabolic interpolation through the peak and its neighbors
+        const float a = p[i-1], b = p[i], c = p[i+1];
+        const float denom = a - 2*b + c;
+        const float offset = (denom == 0.0f)?0.0f:0.5f*(a-c)/denom;
+        PeriodogramPeak peak;
+        peak.bin = i;
+        peak.power = b - 0.25f*(a-c)*offset;
+        peak.freq = trace[int(i)].x() + offset*(trace[int(i+1)].x() - trace[int(i-1)].x())/2;
+        _peaks.push_back(peak);
+    }
+
+    return _peaks;
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <QVector>
+#include <QPointF>
+#include <vector>
+#include <cstddef>
+
+//! A peak in the periodogram trace
+struct PeriodogramPeak
+{
+    double freq; //!< interpolated position on the frequency axis
+    float power; //!< interpolated power in dB
+    size_t bin; //!< the index of the local maximum
+};
+
+/*!
+ * Top-N peak finder for periodogram traces.
+ *
+ * Local maxima that exceed the noise floor of the trace by the threshold
+ * are candidates. Candidates are heaped by power and accepted in order
+ * until N peaks are found, skipping candidates within the minimum
+ * separation of an accepted peak, so the cost is linear in the trace size.
+ * Each peak is refined with a parabola through the neighboring bins.
+ */
+class PeriodogramPeakFinder
+{
+public:
+    PeriodogramPeakFinder(void);
+
+    //! The maximum number of peaks to find, 0 disables the search
+    void setNumPeaks(const size_t numPeaks);
+
+    size_t numPeaks(void) const
+    {
+        return _numPeaks;
+    }
+
+    //! Set the threshold in dB above the noise floor
+    void setThreshold(const double threshold);
+
+    //! Set the minimum number of bins between peaks
+    void setMinSeparation(const size_t numBins);
+
+    //! Find the peaks of the trace in order of descending power
+    const std::vector<PeriodogramPeak> &find(const QVector<QPointF> &trace, const float noiseFloor);
+
+private:
+    size_t _numPeaks;
+    float _threshold;
+    size_t _minSeparation;
+    std::vector<float> _power;
+    std::vector<size_t> _candidates;
+    std::vector<PeriodogramPeak> _peaks;
+};
@@ -0,0 +1,133 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PeriodogramPersistence.hpp"
+#include <qwt_scale_map.h>
+#include <QPainter>
+#include <QImage>
+#include <QColor>
+#include <algorithm> //min/max
+#include <chrono>
+#include <cmath>
+
+static const size_t PERSISTENCE_ROWS = 256;
+static const size_t PERSISTENCE_MAX_COLS = 4096;
+static const uint32_t PERSISTENCE_HIT = 4096; //counts added per hit, saturates after 16 hits
+
+PeriodogramPersistenceItem::PeriodogramPersistenceItem(void):
+    _decayTime(1.0),
+    _toAxis(1.0),
+    _lastTime(0.0),
+    _rate(0.0),
+    _freq(0.0),
+    _powerLow(0.0),
+    _powerHigh(0.0),
+    _numBins(0),
+    _numCols(0)
+{
+    this->setZ(10.0); //under the curves
+
+    //transparent for no hits, then blue through red with the density
+    _colorTable.resize(256);
+    _colorTable[0] = qRgba(0, 0, 0, 0);
+    for (size_t i = 1; i < _colorTable.size(); i++)
+    {
+        const double level = double(i)/(_colorTable.size()-1);
+        const auto color = QColor::fromHsvF(0.66*(1.0-level), 1.0, 1.0, std::min(0.25 + level, 1.0));
+        _colorTable[i] = color.rgba();
+    }
+}
+
+void PeriodogramPersistenceItem::setDecayTime(const double seconds)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _decayTime = seconds;
+}
+
+void PeriodogramPersistenceItem::setFreqAxisScale(const double toAxis)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _toAxis = toAxis;
+}
+
+void PeriodogramPersistenceItem::feed(const std::valarray<float> &powerBins, const double rate, const double freq, const double powerLow, const double powerHigh)
+{
+    if (powerBins.size() == 0 or powerHigh <= powerLow) return;
+    const size_t numCols = std::min(powerBins.size(), PERSISTENCE_MAX_COLS);
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    //map each bin to the row of its power, bins outside the range are skipped,
+    //several bins can hit the same column when the frame is wider than the grid
+    _rows.resize(powerBins.size());
+    const float scale = float(PERSISTENCE_ROWS/(powerHigh-powerLow));
+    const float high = float(powerHigh);
+    for (size_t i = 0; i < powerBins.size(); i++)
+    {
+        _rows[i] = int(std::floor((high - powerBins[i])*scale));
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    //restart the grid when the band or layout changes
+    if (powerBins.size() != _numBins or rate != _rate or freq != _freq or powerLow != _powerLow or powerHigh != _powerHigh)
+    {
+        _numBins = powerBins.size();
+        _numCols = numCols;
+        _rate = rate;
+        _freq = freq;
+        _powerLow = powerLow;
+        _powerHigh = powerHigh;
+        _grid.assign(_numCols*PERSISTENCE_ROWS, 0);
+        _lastTime = time;
+    }
+
+    //exponential decay over the time since the last frame in 16-bit fixed point,
+    //the factor is below one so every count decreases and eventually clears
+    const double decay = (_decayTime <= 0.0)?0.0:std::exp(-(time-_lastTime)/_decayTime);
+    const uint32_t factor = uint32_t(std::min(decay*65536, 65535.0));
+    _lastTime = time;
+    uint16_t *grid = _grid.data();
+    for (size_t i = 0; i < _grid.size(); i++) grid[i] = uint16_t((grid[i]*factor) >> 16);
+
+    //add the hits
+    for (size_t i = 0; i < powerBins.size(); i++)
+    {
+        const int row = _rows[i];
+        if (row < 0 or row >= int(PERSISTENCE_ROWS)) continue;
+        auto &cell = grid[row*_numCols + (i*_numCols)/powerBins.size()];
+        cell = uint16_t(std::min<uint32_t>(cell + PERSISTENCE_HIT, 0xffff));
+    }
+}
+
+void PeriodogramPersistenceItem::clear(void)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _numBins = 0;
+    _numCols = 0;
+    _grid.clear();
+}
+
+void PeriodogramPersistenceItem::draw(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_grid.empty()) return;
+
+    //colorize the counts, the image has one pixel per cell
+    QImage image(int(_numCols), int(PERSISTENCE_ROWS), QImage::Format_ARGB32);
+    for (size_t row = 0; row < PERSISTENCE_ROWS; row++)
+    {
+        auto line = reinterpret_cast<QRgb *>(image.scanLine(int(row)));
+        const uint16_t *cells = _grid.data() + row*_numCols;
+        for (size_t col = 0; col < _numCols; col++) line[col] = _colorTable[cells[col] >> 8];
+    }
+
+    //the columns span the bins, which are centered like the curve points
+    const double binWidth = _rate/std::max<size_t>(_numBins-1, 1);
+    const double x0 = xMap.transform((_freq - _rate/2 - binWidth/2)*_toAxis);
+    const double x1 = xMap.transform((_freq + _rate/2 + binWidth/2)*_toAxis);
+    const double y0 = yMap.transform(_powerHigh);
+    const double y1 = yMap.transform(_powerLow);
+    lock.unlock();
+
+    painter->drawImage(QRectF(QPointF(x0, y0), QPointF(x1, y1)).normalized(), image);
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <qwt_plot_item.h>
+#include <QRgb>
+#include <valarray>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+/*!
+ * Plot item that draws a persistence (density) view under the traces.
+ *
+ * Each frame of power bins hits one cell per frequency column in a grid
+ * of 16-bit counts, where the rows span the displayed power range.
+ * Counts decay exponentially with the time between frames, so intermittent
+ * signals fade out over the persistence time. Frames are added from the
+ * work thread and the grid is colorized through a lookup table when drawn.
+ */
+class PeriodogramPersistenceItem : public QwtPlotItem
+{
+public:
+    PeriodogramPersistenceItem(void);
+
+    //! Set the time constant of the decay in seconds
+    void setDecayTime(const double seconds);
+
+    //! Convert frequencies in Hz to the frequency axis
+    void setFreqAxisScale(const double toAxis);
+
+    /*!
+     * Add a frame of power bins in dB spanning rate Hz around freq.
+     * The rows of the grid span powerLow to powerHigh in dB.
+     * The grid restarts when the band, the bins, or the power range change.
+     */
+    void feed(const std::valarray<float> &powerBins, const double rate, const double freq, const double powerLow, const double powerHigh);
+
+    void clear(void);
+
+    void draw(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect) const;
+
+private:
+    mutable std::mutex _mutex;
+    double _decayTime;
+    double _toAxis;
+    double _lastTime;
+    double _rate, _freq;
+    double _powerLow, _powerHigh;
+    size_t _numBins; //!< bins per frame, the grid may have fewer columns
+    size_t _numCols;
+    std::vector<uint16_t> _grid; //!< row major from the highest power row
+    std::vector<int> _rows; //!< scratch row of each column for the current frame
+    std::vector<QRgb> _colorTable;
+};
@@ -3,28 +3,184 @@
 
 #include "PeriodogramDisplay.hpp"
 #include "PeriodogramChannel.hpp"
+#include "PeriodogramPersistence.hpp"
 #include "PothosPlotter.hpp"
+#include "PothosPlotUtils.hpp"
 #include <qwt_plot_curve.h>
 #include <qwt_plot.h>
+#include <qwt_plot_zoomer.h>
 #include <complex>
+#include <cmath>
+#include <chrono>
+#include <limits>
 
 /***********************************************************************
  * work functions
  **********************************************************************/
-void PeriodogramDisplay::handlePowerBins(const int index, const std::valarray<float> &powerBins)
+void PeriodogramDisplay::handlePowerBins(const int index, const std::valarray<float> &powerBins, const double rate, const double freq)
 {
     if (_queueDepth.at(index)->fetch_sub(1) != 1) return;
 
     auto &curve = _curves[index];
     if (not curve) curve.reset(new PeriodogramChannel(index, _mainPlot));
-    curve->update(powerBins, _sampleRateWoAxisUnits, _centerFreqWoAxisUnits, _averageFactor);
+    curve->setHoldDecay(_holdDecay);
+    curve->setBlockAverage(_blockAverage);
+    if (_sweepEnabled) return this->handleSweepBins(index);
+    const double toAxis = _sampleRateWoAxisUnits/_sampleRate;
+    curve->update(powerBins, rate*toAxis, freq*toAxis, _averageFactor);
+    this->detectPeaks(index, this->updateNoiseFloor(index));
+    this->measureBands(index);
+    this->updateAutoScale();
     _mainPlot->replot();
 }
 
+void PeriodogramDisplay::updateSweep(const int index, const std::valarray<float> &powerBins, const double rate, const double freq)
+{
+    //store the frame in the segment for its tuned center frequency
+    std::lock_guard<std::mutex> lock(_sweepMutex);
+    auto &sweep = _sweeps[index];
+    sweep.setTrim(_sweepTrim);
+    sweep.setMaxAge(_sweepMaxAge);
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    sweep.update(powerBins, freq, rate, time);
+}
+
+void PeriodogramDisplay::handleSweepBins(const int index)
+{
+    //stitch at the native resolution of the segments,
+    //gaps between segments are drawn at the bottom of the display range
+    double lo = 0.0, hi = 0.0;
+    std::valarray<float> bins;
+    {
+        std::lock_guard<std::mutex> lock(_sweepMutex);
+        const auto &sweep = _sweeps[index];
+        if (not sweep.extent(lo, hi)) return;
+        const size_t numBins = std::min<size_t>(std::max<size_t>(sweep.numBins(), 2), 1 << 16);
+        bins = sweep.resample(lo, hi, numBins, float(_refLevel-_dynRange));
+    }
+
+    //the first channel's sweep determines the axis
+    if (index == 0 and (lo != _sweepLow or hi != _sweepHigh))
+    {
+        _sweepLow = lo;
+        _sweepHigh = hi;
+        this->handleUpdateAxis();
+    }
+
+    const double toAxis = _sampleRateWoAxisUnits/_sampleRate;
+    _curves[index]->update(bins, (hi-lo)*toAxis, (hi+lo)/2*toAxis, _averageFactor);
+    this->detectPeaks(index, this->updateNoiseFloor(index));
+    this->measureBands(index);
+    this->updateAutoScale();
+    _mainPlot->replot();
+}
+
+void PeriodogramDisplay::updateAutoScale(void)
+{
+    //the auto reference level owns the axis, and zooming in freezes the axis
+    if (not _autoScale or _autoRefLevel or _mainPlot->zoomer()->zoomRectIndex() != 0) return;
+
+    //the bounds were tracked as the curves were written,
+    //so qwt does not rescan every sample for an autoscaled axis
+    QwtInterval bounds;
+    for (const auto &pair : _curves) bounds |= pair.second->bounds();
+    for (const auto &pair : _crossCurves)
+    {
+        if (pair.second->isVisible()) bounds |= _crossBounds[pair.first];
+    }
+    if (not bounds.isValid()) return;
+    if (not _autoScaler.update(bounds.minValue(), bounds.maxValue())) return;
+
+    //the zoom base follows the scale so that zooming out returns to it
+    _mainPlot->setAxisScale(QwtPlot::yLeft, _autoScaler.lower(), _autoScaler.upper());
+    _mainPlot->updateAxes();
+    _mainPlot->zoomer()->setZoomBase(false);
+}
+
+float PeriodogramDisplay::updateNoiseFloor(const int index)
+{
+    const float floor = _curves[index]->noiseFloor(_noiseFloorPercentile);
+    {
+        std::lock_guard<std::mutex> lock(_noiseFloorMutex);
+        _noiseFloors[index] = floor;
+    }
+
+    //the first channel's noise floor is emitted when it moves to another bucket
+    if (index != 0 or floor == _lastNoiseFloor) return floor;
+    _lastNoiseFloor = floor;
+    this->emitSignal("noiseFloorChanged", double(floor));
+
+    //move the axis when zoomed all the way out and the floor moves by more than a dB
+    if (not _autoRefLevel or _mainPlot->zoomer()->zoomRectIndex() != 0) return floor;
+    if (std::abs(floor - _axisNoiseFloor) < 1.0) return floor;
+    _axisNoiseFloor = floor;
+    const double yLow = _axisNoiseFloor-0.1*_dynRange;
+    _mainPlot->setAxisScale(QwtPlot::yLeft, yLow, yLow+_dynRange);
+    _mainPlot->updateAxes();
+    _mainPlot->zoomer()->setZoomBase(false);
+    return floor;
+}
+
+void PeriodogramDisplay::detectPeaks(const int index, const float noiseFloor)
+{
+    auto &curve = _curves[index];
+    if (_peakFinder.numPeaks() == 0) return curve->updatePeaks(std::vector<PeriodogramPeak>());
+
+    //peaks of the averaged trace, the trace is in axis units
+    const auto &peaks = _peakFinder.find(curve->samples(), noiseFloor);
+    curve->updatePeaks(peaks);
+
+    const double toHz = _sampleRate/_sampleRateWoAxisUnits;
+    Pothos::ObjectVector peakList;
+    for (const auto &peak : peaks)
+    {
+        Pothos::ObjectKwargs peakInfo;
+        peakInfo["channel"] = Pothos::Object(index);
+        peakInfo["freq"] = Pothos::Object(peak.freq*toHz);
+        peakInfo["power"] = Pothos::Object(double(peak.power));
+        peakList.push_back(Pothos::Object(peakInfo));
+    }
+    this->emitSignal("peaksDetected", peakList);
+}
+
+void PeriodogramDisplay::measureBands(const int index)
+{
+    const auto bands = _measureBands;
+    if (bands.empty()) return;
+    _bandMeter.setTrace(_curves[index]->samples());
+
+    //the trace is in axis units, the bands and measurements are in Hz
+    const double toAxis = _sampleRateWoAxisUnits/_sampleRate;
+    Pothos::ObjectVector measurements;
+    double mainPower = std::numeric_limits<double>::quiet_NaN();
+    for (size_t i = 0; i < bands.size()/2; i++)
+    {
+        PeriodogramBandMeasurement result;
+        if (not _bandMeter.measure(bands[2*i]*toAxis, bands[2*i+1]*toAxis, _occupiedFraction, result)) continue;
+        if (i == 0) mainPower = result.power;
+        Pothos::ObjectKwargs measurement;
+        measurement["channel"] = Pothos::Object(index);
+        measurement["band"] = Pothos::Object(i);
+        measurement["freqLow"] = Pothos::Object(bands[2*i]);
+        measurement["freqHigh"] = Pothos::Object(bands[2*i+1]);
+        measurement["power"] = Pothos::Object(result.power);
+        measurement["acpr"] = Pothos::Object(result.power - mainPower);
+        measurement["obw"] = Pothos::Object(result.occupiedBandwidth/toAxis);
+        measurements.push_back(Pothos::Object(measurement));
+    }
+    this->emitSignal("measurements", measurements);
+}
+
 void PeriodogramDisplay::work(void)
 {
     auto inPort = this->input(0);
 
+    //the trigger captures enough samples to decimate and fold down to the FFT size,
+    //emitted from work so the topology is active when the size changes at startup
+    const auto numPoints = this->numInputPoints(std::atomic_load(&_freqZoom));
+    if (numPoints != _lastNumPoints) this->call("numPointsChanged", numPoints);
+    _lastNumPoints = numPoints;
+
     if (not inPort->hasMessage()) return;
     const auto msg = inPort->popMessage();
 
@@ -50,11 +206,17 @@ void PeriodogramDisplay::work(void)
         const auto index = (indexIt == packet.metadata.end())?0:indexIt->second.convert<int>();
         const auto &buff = packet.payload;
         std::valarray<float> powerBins;
+        CArray fftBins;
+        double rate = _sampleRate;
+        double freq = _centerFreq;
+        const auto zoom = std::atomic_load(&_freqZoom);
 
-        //handle automatic FFT mode
+        //handle automatic FFT mode,
+        //the power output of another plotter is real when it has the half spectrum
         if (_fftModeAutomatic and index == 0)
         {
-            const bool isComplex = buff.dtype.isComplex();
+            const auto halfIt = packet.metadata.find("halfSpectrum");
+            const bool isComplex = (halfIt == packet.metadata.end())?buff.dtype.isComplex():not halfIt->second.convert<bool>();
             const bool changed = _fftModeComplex != isComplex;
             _fftModeComplex = isComplex;
             if (changed) QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
@@ -68,20 +230,172 @@ void PeriodogramDisplay::work(void)
         {
             auto floatBuff = buff.convert(Pothos::DType(typeid(float)), buff.elements());
             powerBins = std::valarray<float>(floatBuff.as<const float *>(), floatBuff.elements());
+
+            //the power output of another plotter describes its band,
+            //a half spectrum from real input spans DC to +fs/2
+            const auto rateIt = packet.metadata.find("sampleRate");
+            if (rateIt != packet.metadata.end()) rate = rateIt->second.convert<double>();
+            const auto freqIt = packet.metadata.find("centerFreq");
+            if (freqIt != packet.metadata.end()) freq = freqIt->second.convert<double>();
+            const auto halfIt = packet.metadata.find("halfSpectrum");
+            if (halfIt != packet.metadata.end() and halfIt->second.convert<bool>())
+            {
+                rate /= 2;
+                freq += rate/2;
+            }
+        }
+
+        //the zoomed band is mixed and decimated down to the FFT size,
+        //each capture is independent so the filter starts from a reset state
+        else if (zoom)
+        {
+            //safe guard against FFT size and zoom changes, old buffers could still be in-flight
+            const size_t numInput = this->numInputPoints(zoom);
+            if (buff.elements() != numInput) return;
+            auto floatBuff = buff.convert(Pothos::DType(typeid(std::complex<float>)), buff.elements());
+            _zoomSamps.clear();
+            zoom->reset();
+            zoom->feed(floatBuff.as<const std::complex<float> *>(), numInput, _zoomSamps);
+            fftBins = CArray(_zoomSamps.data(), _zoomSamps.size());
+            rate = zoom->outputRate();
+            freq += zoom->offset();
+            powerBins = this->transformBins(fftBins, index, rate, freq);
         }
 
         //power bins to points on the curve
         else
         {
             //safe guard against FFT size changes, old buffers could still be in-flight
-            if (buff.elements() != this->numFFTBins()) return;
+            const size_t numInput = this->numInputPoints(nullptr);
+            if (buff.elements() != numInput) return;
             auto floatBuff = buff.convert(Pothos::DType(typeid(std::complex<float>)), buff.elements());
-            CArray fftBins(floatBuff.as<const std::complex<float> *>(), this->numFFTBins());
-            powerBins = _fftPowerSpectrum.transform(fftBins, _fullScale);
+            fftBins = CArray(floatBuff.as<const std::complex<float> *>(), numInput);
+            powerBins = this->transformBins(fftBins, index, rate, freq);
+        }
+
+        //every frame is stitched into the sweep and the first channel hits the persistence grid,
+        //including the frames that are dropped when the display falls behind
+        if (_sweepEnabled) this->updateSweep(index, powerBins, rate, freq);
+        if (_persistenceEnabled and index == 0 and not _sweepEnabled)
+        {
+            _persistence->feed(powerBins, rate, freq, _refLevel-_dynRange, _refLevel);
+        }
+
+        //the transforms are reused for the cross-spectra between channels
+        if (not _crossMode.empty() and not _sweepEnabled and fftBins.size() != 0)
+        {
+            this->updateCrossSpectra(index, fftBins, rate, freq);
         }
 
         if (not _queueDepth[index]) _queueDepth[index].reset(new std::atomic<size_t>(0));
         _queueDepth[index]->fetch_add(1);
-        QMetaObject::invokeMethod(this, "handlePowerBins", Qt::QueuedConnection, Q_ARG(int, index), Q_ARG(std::valarray<float>, powerBins));
+        QMetaObject::invokeMethod(this, "handlePowerBins", Qt::QueuedConnection, Q_ARG(int, index), Q_ARG(std::valarray<float>, powerBins), Q_ARG(double, rate), Q_ARG(double, freq));
     }
 }
+
+std::valarray<float> PeriodogramDisplay::transformBins(CArray &fftBins, const int index, const double rate, const double freq)
+{
+    if (not _powerOutput) return _fftPowerSpectrum.transform(fftBins, _fullScale);
+
+    //transform directly into the output buffer, the packet shares it downstream
+    Pothos::BufferChunk buff(typeid(float), _fftPowerSpectrum.outputSize(fftBins.size()));
+    if (buff.elements() == 0) return std::valarray<float>();
+    _fftPowerSpectrum.transform(fftBins, buff.as<float *>(), _fullScale);
+
+    Pothos::Packet packet;
+    packet.payload = buff;
+    packet.metadata["format"] = Pothos::Object(std::string("POWER_BINS"));
+    packet.metadata["index"] = Pothos::Object(index);
+    packet.metadata["sampleRate"] = Pothos::Object(rate);
+    packet.metadata["centerFreq"] = Pothos::Object(freq);
+    packet.metadata["halfSpectrum"] = Pothos::Object(false);
+    this->output(0)->postMessage(packet);
+
+    return std::valarray<float>(buff.as<const float *>(), buff.elements());
+}
+
+/***********************************************************************
+ * cross-spectra between channels
+ **********************************************************************/
+void PeriodogramDisplay::updateCrossSpectra(const int index, const CArray &fftBins, const double rate, const double freq)
+{
+    _crossFrames[index].bins = fftBins;
+    _crossFrames[index].seq++;
+    _crossNumChannels = std::max<size_t>(_crossNumChannels, index+1);
+
+    //the pairs of channels for the pair mode
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (size_t k = 1; k < _crossNumChannels; k++)
+    {
+        if (_crossMode == "REFERENCE") pairs.emplace_back(0, k);
+        if (_crossMode == "ADJACENT") pairs.emplace_back(k-1, k);
+    }
+
+    for (const auto &pair : pairs)
+    {
+        if (pair.first != size_t(index) and pair.second != size_t(index)) continue;
+
+        //both channels need a new frame since the last update of this pair,
+        //the aligned trigger outputs one frame per channel for each capture
+        const auto &x = _crossFrames[pair.first];
+        const auto &y = _crossFrames[pair.second];
+        auto &cross = _crossSpectra[pair];
+        if (x.seq == cross.seqX or y.seq == cross.seqY) continue;
+        if (x.bins.size() != y.bins.size()) continue;
+        cross.seqX = x.seq;
+        cross.seqY = y.seq;
+
+        //the average restarts when the band changes
+        if (rate != cross.rate or freq != cross.freq) cross.spectrum.reset();
+        cross.rate = rate;
+        cross.freq = freq;
+        cross.spectrum.setNumAverages(_crossAverage);
+        cross.spectrum.update(x.bins, y.bins);
+
+        const auto density = cross.spectrum.density(_fftPowerSpectrum.gainDB(x.bins.size(), _fullScale));
+        const auto coherence = cross.spectrum.coherence();
+        const auto phase = cross.spectrum.phase();
+        const auto &trace = (_crossDisplay == "COHERENCE")?coherence:((_crossDisplay == "PHASE")?phase:density);
+        QMetaObject::invokeMethod(this, "handleCrossBins", Qt::QueuedConnection,
+            Q_ARG(int, int(pair.first)), Q_ARG(int, int(pair.second)),
+            Q_ARG(std::valarray<float>, trace), Q_ARG(double, rate), Q_ARG(double, freq));
+
+        Pothos::ObjectKwargs crossInfo;
+        crossInfo["channelX"] = Pothos::Object(pair.first);
+        crossInfo["channelY"] = Pothos::Object(pair.second);
+        crossInfo["sampleRate"] = Pothos::Object(rate);
+        crossInfo["centerFreq"] = Pothos::Object(freq);
+        crossInfo["density"] = Pothos::Object(std::vector<float>(std::begin(density), std::end(density)));
+        crossInfo["coherence"] = Pothos::Object(std::vector<float>(std::begin(coherence), std::end(coherence)));
+        crossInfo["phase"] = Pothos::Object(std::vector<float>(std::begin(phase), std::end(phase)));
+        this->emitSignal("crossSpectrum", crossInfo);
+    }
+}
+
+void PeriodogramDisplay::handleCrossBins(const int channelX, const int channelY, const std::valarray<float> &bins, const double rate, const double freq)
+{
+    auto &curve = _crossCurves[std::make_pair(size_t(channelX), size_t(channelY))];
+    if (not curve)
+    {
+        curve.reset(new QwtPlotCurve(QString("Cross%1-%2").arg(channelX).arg(channelY)));
+        curve->setPen(pastelize(getDefaultCurveColor(2*channelX+channelY+24)));
+        curve->attach(_mainPlot);
+        _mainPlot->updateChecked(curve.get());
+    }
+
+    //bins are in FFT order across the band like the channel curves
+    const double toAxis = _sampleRateWoAxisUnits/_sampleRate;
+    QVector<QPointF> points(int(bins.size()));
+    float lo(std::numeric_limits<float>::infinity()), hi(-lo);
+    for (size_t i = 0; i < bins.size(); i++)
+    {
+        const double x = (rate*i)/std::max<size_t>(bins.size()-1, 1) - rate/2 + freq;
+        points[int(i)] = QPointF(x*toAxis, bins[i]);
+        lo = std::min(lo, bins[i]);
+        hi = std::max(hi, bins[i]);
+    }
+    curve->setSamples(points);
+    _crossBounds[std::make_pair(size_t(channelX), size_t(channelY))] = QwtInterval(lo, hi);
+    this->updateAutoScale();
+    _mainPlot->replot();
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PothosAutoScaler.hpp"
+#include <cmath>
+#include <algorithm> //min/max
+
+PothosAutoScaler::PothosAutoScaler(void):
+    _margin(0.05),
+    _shrink(0.5),
+    _valid(false),
+    _lower(0.0),
+    _upper(0.0)
+{
+    return;
+}
+
+void PothosAutoScaler::setMargin(const double margin)
+{
+    _margin = std::max(margin, 0.0);
+}
+
+void PothosAutoScaler::setShrinkFraction(const double fraction)
+{
+    _shrink = std::min(std::max(fraction, 0.0), 1.0);
+}
+
+void PothosAutoScaler::reset(void)
+{
+    _valid = false;
+}
+
+bool PothosAutoScaler::update(const double lower, const double upper)
+{
+    if (not std::isfinite(lower) or not std::isfinite(upper) or lower > upper) return false;
+
+    //keep the scale while it contains the data and the data fills enough of it
+    const bool inside = lower >= _lower and upper <= _upper;
+    if (_valid and inside and (upper-lower) >= _shrink*(_upper-_lower)) return false;
+
+    //fit the scale to the data with a margin, flat data gets a margin around its level
+    double margin = _margin*(upper-lower);
+    if (upper == lower) margin = std::max(std::abs(upper), 1.0)*std::max(_margin, 0.01);
+    _lower = lower-margin;
+    _upper = upper+margin;
+    _valid = true;
+    return true;
+}
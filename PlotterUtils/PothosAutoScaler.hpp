@@ -0,0 +1,56 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include "PlotUtilsConfig.hpp"
+
+/*!
+ * Automatic axis scaling from bounds tracked by the display.
+ *
+ * The display computes the bounds of each frame as it writes the curve samples,
+ * and sets the axis scale from this class instead of enabling autoscale on the
+ * axis, which makes Qwt scan every sample of every curve on each replot.
+ *
+ * The scale expands as soon as the data leaves it, and only shrinks
+ * when the data spans less than the shrink fraction of the scale,
+ * so that the axis does not jitter with the data from frame to frame.
+ */
+class POTHOS_PLOTTER_UTILS_EXPORT PothosAutoScaler
+{
+public:
+    PothosAutoScaler(void);
+
+    //! The fraction of the data span added above and below the data
+    void setMargin(const double margin);
+
+    //! Shrink the scale when the data spans less than this fraction of it
+    void setShrinkFraction(const double fraction);
+
+    //! Forget the scale, the next update fits the scale to the data
+    void reset(void);
+
+    //! Update with the bounds of the data, true when the scale changed
+    bool update(const double lower, const double upper);
+
+    //! True when the scale was set by an update
+    bool isValid(void) const
+    {
+        return _valid;
+    }
+
+    double lower(void) const
+    {
+        return _lower;
+    }
+
+    double upper(void) const
+    {
+        return _upper;
+    }
+
+private:
+    double _margin;
+    double _shrink;
+    bool _valid;
+    double _lower, _upper;
+};
@@ -12,6 +12,8 @@
 #include <qwt_legend_label.h>
 #include <qwt_text.h>
 #include <QMouseEvent>
+#include <QFile>
+#include <QByteArray>
 
 QColor getDefaultCurveColor(const size_t whichCurve)
 {
@@ -39,3 +41,27 @@ QColor pastelize(const QColor &c)
     //http://en.wikipedia.org/wiki/Pastel_%28color%29
     return QColor::fromHsv(c.hue(), int(c.saturationF()*128), int(c.valueF()*64)+191);
 }
+
+bool writeNumpyFloat32(const QString &path, const size_t numRows, const size_t numCols, const float *data)
+{
+    //format version 1.0: magic, version, header length, then a python dict
+    //padded with spaces and a newline so that the data is 16-byte aligned
+    QByteArray header = QString("{'descr': '<f4', 'fortran_order': False, 'shape': (%1, %2), }")
+        .arg(qulonglong(numRows)).arg(qulonglong(numCols)).toLatin1();
+    const int prefixLen = 6 + 2 + 2;
+    while ((prefixLen + header.size() + 1) % 16 != 0) header.append(' ');
+    header.append('\n');
+
+    QByteArray prefix("\x93NUMPY\x01\x00", 8);
+    prefix.append(char(header.size() & 0xff));
+    prefix.append(char((header.size() >> 8) & 0xff));
+
+    //the data is written in the native byte order, which is little endian on supported hosts
+    QFile file(path);
+    if (not file.open(QIODevice::WriteOnly)) return false;
+    const qint64 dataLen = qint64(numRows*numCols*sizeof(float));
+    if (file.write(prefix) != prefix.size()) return false;
+    if (file.write(header) != header.size()) return false;
+    if (dataLen != 0 and file.write(reinterpret_cast<const char *>(data), dataLen) != dataLen) return false;
+    return true;
+}
@@ -4,9 +4,14 @@
 #pragma once
 #include "PlotUtilsConfig.hpp"
 #include <QColor>
+#include <QString>
+#include <cstddef>
 
 //! Get a color for a plotter curve given an index
 POTHOS_PLOTTER_UTILS_EXPORT QColor getDefaultCurveColor(const size_t whichCurve);
 
 //! make a color have pastel-properties
 POTHOS_PLOTTER_UTILS_EXPORT QColor pastelize(const QColor &c);
+
+//! Write a row-major 2D array of floats to a numpy .npy file, returns false on error
+POTHOS_PLOTTER_UTILS_EXPORT bool writeNumpyFloat32(const QString &path, const size_t numRows, const size_t numCols, const float *data);
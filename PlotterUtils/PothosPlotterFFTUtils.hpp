@@ -6,6 +6,7 @@
 #include <cmath>
 #include <complex>
 #include <valarray>
+#include <vector>
 #include <string>
 #include <cassert>
 #include <algorithm>
@@ -57,58 +58,374 @@ inline void ifft(CArray& x)
     x /= x.size();
 }
 
+////////////////////////////////////////////////////////////////////////
+//FFT plan: iterative radix-2 FFT with precomputed twiddles
+////////////////////////////////////////////////////////////////////////
+struct FFTPlan
+{
+    FFTPlan(void):
+        _size(0),
+        _radix2(false){}
+
+    //! Transform in-place, the plan is recomputed when the size changes.
+    //! Sizes that are not a power of two use the recursive fft().
+    void operator()(CArray &x)
+    {
+        const size_t N = x.size();
+        if (N != _size) this->init(N);
+        if (not _radix2) return fft(x);
+
+        //bit reversed reorder
+        Complex *p = &x[0];
+        for (size_t i = 0; i < N; i++)
+        {
+            if (i < _bitReverse[i]) std::swap(p[i], p[_bitReverse[i]]);
+        }
+
+        //butterflies: the twiddle stride halves with each stage
+        for (size_t half = 1, stride = N/2; half < N; half *= 2, stride /= 2)
+        {
+            for (size_t i = 0; i < N; i += 2*half)
+            {
+                for (size_t k = 0; k < half; k++)
+                {
+                    const Complex w = _twiddles[k*stride];
+                    const Complex b = p[i+k+half];
+                    const Complex t(w.real()*b.real() - w.imag()*b.imag(), w.real()*b.imag() + w.imag()*b.real());
+                    p[i+k+half] = p[i+k] - t;
+                    p[i+k] += t;
+                }
+            }
+        }
+    }
+
+    void init(const size_t N)
+    {
+        _size = N;
+        _radix2 = (N > 1) and ((N & (N-1)) == 0);
+        _twiddles.clear();
+        _bitReverse.clear();
+        if (not _radix2) return;
+
+        _twiddles.resize(N/2);
+        for (size_t k = 0; k < N/2; k++)
+        {
+            _twiddles[k] = Complex(std::polar(1.0, -2*M_PI*k/N));
+        }
+
+        size_t numBits = 0;
+        while ((size_t(1) << numBits) < N) numBits++;
+        _bitReverse.resize(N);
+        for (size_t i = 0; i < N; i++)
+        {
+            size_t r = 0;
+            for (size_t b = 0; b < numBits; b++) r |= ((i >> b) & 1) << (numBits-1-b);
+            _bitReverse[i] = r;
+        }
+    }
+
+    size_t _size;
+    bool _radix2;
+    std::vector<Complex> _twiddles;
+    std::vector<size_t> _bitReverse;
+};
+
 ////////////////////////////////////////////////////////////////////////
 //FFT Power spectrum
 ////////////////////////////////////////////////////////////////////////
 struct FFTPowerSpectrum
 {
+    FFTPowerSpectrum(void):
+        _precomputedWindowPower(1.0),
+        _pfbTaps(1),
+        _pfbPower(1.0){}
+
+    /*!
+     * Set the window function by name, see spuce::design_window().
+     * The "pfb" window type selects a polyphase filter bank estimator,
+     * windowArgs may specify [taps] per branch (default 4).
+     */
     void setWindowType(const std::string &windowType, const std::vector<double> &windowArgs)
     {
         _windowType = windowType;
         _windowArgs = windowArgs;
+        _pfbTaps = 1;
+        if (windowType == "pfb") _pfbTaps = windowArgs.empty()?4:size_t(std::max(windowArgs.at(0), 1.0));
         _precomputedWindow.clear();
+        _pfbCoeffs.clear();
+    }
+
+    //! The number of input samples needed to transform into numBins bins
+    size_t inputSize(const size_t numBins) const
+    {
+        return numBins*_pfbTaps;
+    }
+
+    /*!
+     * Window and transform the samples into power bins in dB.
+     * The full spectrum is reordered from -fs/2 to +fs/2.
+     * The half spectrum (for real input) contains N/2+1 bins from DC to +fs/2.
+     * On return, fftBins contains the windowed transform in natural order.
+     * In PFB mode, the inputSize() samples are folded into a transform of inputSize()/taps bins.
+     */
+    std::valarray<float> transform(CArray &fftBins, const double fullScale = 1.0, const bool halfSpectrum = false)
+    {
+        std::valarray<float> powerBins(this->outputSize(fftBins.size(), halfSpectrum));
+        if (powerBins.size() != 0) this->transform(fftBins, &powerBins[0], fullScale, halfSpectrum);
+        return powerBins;
+    }
+
+    //! The number of power bins from a transform of numInput samples
+    size_t outputSize(const size_t numInput, const bool halfSpectrum = false) const
+    {
+        const size_t N = numInput/_pfbTaps;
+        return halfSpectrum?(N/2+1):N;
     }
 
-    std::valarray<float> transform(CArray &fftBins, const double fullScale = 1.0)
+    /*!
+     * Transform into a caller-provided buffer of outputSize() power bins.
+     * This allows the bins to be written directly into an output buffer.
+     */
+    void transform(CArray &fftBins, float *powerBins, const double fullScale = 1.0, const bool halfSpectrum = false)
     {
+        //polyphase filter bank weights and folds the input in place of the window,
+        //the folded samples are not windowed again, the weights are the window
+        if (_pfbTaps > 1) this->foldPFB(fftBins);
+
         //windowing
-        if (_precomputedWindow.size() != fftBins.size())
+        else
         {
-            _precomputedWindow = spuce::design_window(_windowType, fftBins.size(), _windowArgs.empty()?0.0:_windowArgs.at(0));
-            _precomputedWindowPower = 0.0;
-            for (size_t n = 0; n < _precomputedWindow.size(); n++)
+            if (_precomputedWindow.size() != fftBins.size())
             {
-                _precomputedWindowPower += _precomputedWindow[n]*_precomputedWindow[n];
+                _precomputedWindow = spuce::design_window(_windowType, fftBins.size(), _windowArgs.empty()?0.0:_windowArgs.at(0));
+                _precomputedWindowPower = 0.0;
+                for (size_t n = 0; n < _precomputedWindow.size(); n++)
+                {
+                    _precomputedWindowPower += _precomputedWindow[n]*_precomputedWindow[n];
+                }
+                _precomputedWindowPower = std::sqrt(_precomputedWindowPower/_precomputedWindow.size());
             }
-            _precomputedWindowPower = std::sqrt(_precomputedWindowPower/_precomputedWindow.size());
+            for (size_t n = 0; n < fftBins.size(); n++) fftBins[n] *= _precomputedWindow[n];
         }
-        for (size_t n = 0; n < fftBins.size(); n++) fftBins[n] *= _precomputedWindow[n];
+        if (fftBins.size() == 0) return;
 
         //take fft
-        fft(fftBins);
+        _fftPlan(fftBins);
 
         //window and fft gain adjustment
-        const float gain_dB = 20*std::log10(fftBins.size()) + 20*std::log10(_precomputedWindowPower) + 20*std::log10(fullScale);
+        const float gain_dB = this->gainDB(fftBins.size(), fullScale);
 
         //power calculation
-        std::valarray<float> powerBins(fftBins.size());
-        for (size_t i = 0; i < fftBins.size(); i++)
+        const size_t numOutput = halfSpectrum?(fftBins.size()/2+1):fftBins.size();
+        for (size_t i = 0; i < numOutput; i++)
         {
             const float norm = std::max(std::norm(fftBins[i]), 1e-20f);
             powerBins[i] = 10*std::log10(norm) - gain_dB;
         }
+        if (halfSpectrum) return;
 
         //bin reorder
-        for (size_t i = 0; i < powerBins.size()/2; i++)
+        for (size_t i = 0; i < numOutput/2; i++)
         {
-            std::swap(powerBins[i], powerBins[i+powerBins.size()/2]);
+            std::swap(powerBins[i], powerBins[i+numOutput/2]);
         }
+    }
 
-        return powerBins;
+    //! The gain in dB of the window and transform, valid after a transform of numBins
+    float gainDB(const size_t numBins, const double fullScale = 1.0) const
+    {
+        const double windowPower = (_pfbTaps > 1)?_pfbPower:_precomputedWindowPower;
+        return 20*std::log10(numBins) + 20*std::log10(windowPower) + 20*std::log10(fullScale);
+    }
+
+    /*!
+     * Weight taps*N samples with the prototype low-pass filter and sum the
+     * taps branches of N samples each into N samples. The prototype is a sinc
+     * with a cutoff at the bin spacing shaped by a Hamming window, so each bin
+     * has a flat top and steep skirts instead of the window's main lobe.
+     */
+    void foldPFB(CArray &samps)
+    {
+        const size_t M = _pfbTaps;
+        const size_t N = samps.size()/M;
+        if (N == 0)
+        {
+            samps.resize(0);
+            return;
+        }
+        const size_t L = M*N;
+
+        //precompute the prototype, duplicated for the real and imaginary parts
+        if (_pfbCoeffs.size() != 2*L)
+        {
+            const auto window = spuce::design_window("hamming", L, 0.0);
+            _pfbCoeffs.resize(2*L);
+            _pfbPower = 0.0;
+            for (size_t n = 0; n < L; n++)
+            {
+                const double t = (double(n) - L/2.0)/N;
+                const double sinc = (t == 0.0)?1.0:std::sin(M_PI*t)/(M_PI*t);
+                const double h = sinc*window[n];
+                _pfbCoeffs[2*n+0] = float(h);
+                _pfbCoeffs[2*n+1] = float(h);
+                _pfbPower += h*h;
+            }
+            _pfbPower = std::sqrt(_pfbPower/N);
+        }
+
+        //multiply-accumulate on the interleaved floats,
+        //the inner loop is contiguous and vectorizes without intrinsics
+        _pfbFolded.assign(2*N, 0.0f);
+        const float *x = reinterpret_cast<const float *>(&samps[0]);
+        const float *h = _pfbCoeffs.data();
+        float *y = _pfbFolded.data();
+        for (size_t m = 0; m < M; m++)
+        {
+            const float *xm = x + 2*m*N;
+            const float *hm = h + 2*m*N;
+            for (size_t j = 0; j < 2*N; j++) y[j] += xm[j]*hm[j];
+        }
+
+        samps.resize(N);
+        for (size_t k = 0; k < N; k++) samps[k] = Complex(y[2*k+0], y[2*k+1]);
     }
 
     std::string _windowType;
     std::vector<double> _windowArgs;
     std::vector<double> _precomputedWindow;
     double _precomputedWindowPower;
+    FFTPlan _fftPlan;
+    size_t _pfbTaps;
+    double _pfbPower; //!< the rms gain of the prototype per branch
+    std::vector<float> _pfbCoeffs;
+    std::vector<float> _pfbFolded;
+};
+
+////////////////////////////////////////////////////////////////////////
+//Frequency zoom: mix a band to baseband, low-pass filter, and decimate
+//so that a smaller FFT can resolve the band at a finer bin spacing.
+////////////////////////////////////////////////////////////////////////
+struct FrequencyZoom
+{
+    FrequencyZoom(void):
+        _offset(0.0),
+        _sampleRate(1.0),
+        _decim(1),
+        _next(0),
+        _phase(1.0),
+        _phaseInc(1.0),
+        _taps(1, 1.0f){}
+
+    /*!
+     * Configure the zoom for a band centered at an offset from the input center.
+     * The low-pass filter passes the decimated band with tapsPerPhase taps per polyphase branch.
+     */
+    void configure(const double offset, const double sampleRate, const size_t decim, const size_t tapsPerPhase = 8)
+    {
+        _offset = offset;
+        _sampleRate = sampleRate;
+        _decim = std::max<size_t>(decim, 1);
+        _phaseInc = std::polar(1.0, -2*M_PI*offset/sampleRate);
+
+        //windowed sinc with unity gain at DC, cutoff at the decimated nyquist
+        const size_t numTaps = (_decim == 1)?1:(_decim*tapsPerPhase+1);
+        const auto window = spuce::design_window("blackman", numTaps, 0.0);
+        const double cutoff = 0.5/_decim;
+        _taps.resize(numTaps);
+        double gain = 0.0;
+        for (size_t n = 0; n < numTaps; n++)
+        {
+            const double t = double(n) - (numTaps-1)/2.0;
+            const double sinc = (t == 0.0)?1.0:std::sin(2*M_PI*cutoff*t)/(2*M_PI*cutoff*t);
+            _taps[n] = float(sinc*((numTaps == 1)?1.0:window[n]));
+            gain += _taps[n];
+        }
+        for (auto &tap : _taps) tap = float(tap/gain);
+        this->reset();
+    }
+
+    //! The largest decimation that keeps a bandwidth, bounded to limit the filter length
+    static size_t decimationFor(const double sampleRate, const double bandwidth, const size_t maxDecim = 4096)
+    {
+        if (bandwidth <= 0.0) return 1;
+        return size_t(std::max(std::min(std::floor(sampleRate/bandwidth), double(maxDecim)), 1.0));
+    }
+
+    //! Clear the filter history and the mixer phase
+    void reset(void)
+    {
+        _history.clear();
+        _next = 0;
+        _phase = 1.0;
+    }
+
+    //! The number of input samples to produce numOutputs from a reset state
+    size_t inputSize(const size_t numOutputs) const
+    {
+        return numOutputs*_decim + _taps.size() - 1;
+    }
+
+    size_t decimation(void) const
+    {
+        return _decim;
+    }
+
+    //! The offset of the band center from the input center in Hz
+    double offset(void) const
+    {
+        return _offset;
+    }
+
+    //! The sample rate of the decimated output
+    double outputRate(void) const
+    {
+        return _sampleRate/_decim;
+    }
+
+    /*!
+     * Mix, filter, and decimate the input samples.
+     * The output samples are appended to out.
+     * Only every decim-th output of the filter is computed,
+     * and the state is kept across calls for continuous streams.
+     */
+    void feed(const Complex *in, const size_t numIn, std::vector<Complex> &out)
+    {
+        //mix to baseband, the phase is renormalized to prevent drift
+        for (size_t i = 0; i < numIn; i++)
+        {
+            _history.push_back(in[i]*Complex(_phase));
+            _phase *= _phaseInc;
+        }
+        _phase /= std::abs(_phase);
+
+        //filter the windows that end on an output sample
+        const size_t numTaps = _taps.size();
+        const float *taps = _taps.data();
+        size_t i = _next;
+        for (; i + numTaps <= _history.size(); i += _decim)
+        {
+            const Complex *x = _history.data()+i;
+            float re = 0.0f, im = 0.0f;
+            for (size_t k = 0; k < numTaps; k++)
+            {
+                re += taps[k]*x[k].real();
+                im += taps[k]*x[k].imag();
+            }
+            out.push_back(Complex(re, im));
+        }
+
+        //keep the samples that are needed by the next output
+        const size_t used = std::min(i, _history.size());
+        _history.erase(_history.begin(), _history.begin()+used);
+        _next = i - used;
+    }
+
+    double _offset;
+    double _sampleRate;
+    size_t _decim;
+    size_t _next;
+    std::complex<double> _phase;
+    std::complex<double> _phaseInc;
+    std::vector<float> _taps;
+    std::vector<Complex> _history;
 };
@@ -0,0 +1,147 @@
+// Copyright (c) 2014-2016 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PothosSweepStitcher.hpp"
+#include <cmath>
+#include <algorithm> //min/max
+
+static long long segmentKey(const double centerFreq)
+{
+    return std::llround(centerFreq);
+}
+
+PothosSweepStitcher::PothosSweepStitcher(void):
+    _trim(0.1),
+    _maxAge(0.0)
+{
+    return;
+}
+
+void PothosSweepStitcher::setTrim(const double trim)
+{
+    _trim = std::min(std::max(trim, 0.0), 0.49);
+}
+
+void PothosSweepStitcher::setMaxAge(const double maxAge)
+{
+    _maxAge = std::max(maxAge, 0.0);
+}
+
+void PothosSweepStitcher::clear(void)
+{
+    _segments.clear();
+    _pass.clear();
+}
+
+bool PothosSweepStitcher::isNewPass(const double centerFreq) const
+{
+    return _pass.count(segmentKey(centerFreq)) != 0;
+}
+
+void PothosSweepStitcher::update(const std::valarray<float> &bins, const double centerFreq, const double sampleRate, const double time)
+{
+    if (bins.size() < 2 or sampleRate <= 0.0) return;
+
+    //a segment that was already updated in this pass starts the next pass
+    const auto key = segmentKey(centerFreq);
+    if (_pass.count(key) != 0) _pass.clear();
+    _pass.insert(key);
+
+    auto &segment = _segments[key];
+    segment.bins = bins;
+    segment.centerFreq = centerFreq;
+    segment.sampleRate = sampleRate;
+    segment.time = time;
+
+    //drop segments that are no longer part of the sweep
+    if (_maxAge <= 0.0) return;
+    for (auto it = _segments.begin(); it != _segments.end();)
+    {
+        if (time - it->second.time <= _maxAge) ++it;
+        else
+        {
+            _pass.erase(it->first);
+            it = _segments.erase(it);
+        }
+    }
+}
+
+std::vector<PothosSweepStitcher::Span> PothosSweepStitcher::spans(void) const
+{
+    //trim the edges of each segment, the map is in order of frequency
+    std::vector<Span> spans;
+    for (const auto &pair : _segments)
+    {
+        const auto &segment = pair.second;
+        const double halfWidth = segment.sampleRate*(0.5 - _trim);
+        Span span;
+        span.lo = segment.centerFreq - halfWidth;
+        span.hi = segment.centerFreq + halfWidth;
+        span.segment = &segment;
+
+        //split the overlap with the previous segment halfway
+        if (not spans.empty() and spans.back().hi > span.lo)
+        {
+            const double mid = (spans.back().hi + span.lo)/2;
+            spans.back().hi = std::max(mid, spans.back().lo);
+            span.lo = std::min(mid, span.hi);
+        }
+        spans.push_back(span);
+    }
+    return spans;
+}
+
+bool PothosSweepStitcher::extent(double &freqLow, double &freqHigh) const
+{
+    if (_segments.empty()) return false;
+    const auto spans = this->spans();
+    freqLow = spans.front().lo;
+    freqHigh = spans.back().hi;
+    return freqHigh > freqLow;
+}
+
+size_t PothosSweepStitcher::numBins(void) const
+{
+    double numBins = 0.0;
+    for (const auto &span : this->spans())
+    {
+        const auto &segment = *span.segment;
+        numBins += (span.hi - span.lo)*segment.bins.size()/segment.sampleRate;
+    }
+    return size_t(std::ceil(numBins));
+}
+
+std::valarray<float> PothosSweepStitcher::resample(const double freqLow, const double freqHigh, const size_t numBins, const float fill) const
+{
+    std::valarray<float> out(fill, numBins);
+    if (numBins == 0) return out;
+    const auto spans = this->spans();
+    const double step = (freqHigh - freqLow)/std::max<size_t>(numBins-1, 1);
+
+    //the output bins are in order of frequency, so are the spans
+    size_t s = 0;
+    for (size_t i = 0; i < numBins; i++)
+    {
+        const double freq = freqLow + i*step;
+        while (s < spans.size() and spans[s].hi < freq) s++;
+        if (s == spans.size()) break;
+        if (spans[s].lo > freq) continue;
+
+        //bin k of a segment is at center + (k - N/2)*fs/N
+        const auto &segment = *spans[s].segment;
+        const size_t N = segment.bins.size();
+        const double binWidth = segment.sampleRate/N;
+        const double pos = (freq - segment.centerFreq)/binWidth + N/2;
+        const double reach = step/binWidth/2;
+        const double first = std::max(std::floor(pos - reach + 0.5), 0.0);
+        const double last = std::min(std::ceil(pos + reach + 0.5 - 1e-9) - 1, double(N-1));
+        if (first > last) continue;
+
+        //max over the input bins under the output bin, at least the nearest bin,
+        //an input bin that only touches the upper edge of the output bin is excluded
+        float value = segment.bins[size_t(first)];
+        for (size_t k = size_t(first)+1; k <= size_t(last); k++) value = std::max(value, segment.bins[k]);
+        out[i] = value;
+    }
+    return out;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2014-2016 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include "PlotUtilsConfig.hpp"
+#include <valarray>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstddef>
+
+/*!
+ * Stitch power spectrums from a retuning radio into a panoramic trace.
+ *
+ * Each frame is stored in a segment keyed by its tuned center frequency,
+ * replacing the previous frame for the same center. The edges of each
+ * segment are trimmed to remove the filter roll-off, and segments that
+ * still overlap are split halfway through the overlap.
+ *
+ * Frames are expected as full spectrums in FFT order from -fs/2 to +fs/2.
+ */
+class POTHOS_PLOTTER_UTILS_EXPORT PothosSweepStitcher
+{
+public:
+    PothosSweepStitcher(void);
+
+    //! The fraction of each segment's band trimmed from each edge in [0.0, 0.5)
+    void setTrim(const double trim);
+
+    //! Segments that are not updated for maxAge seconds are dropped, 0.0 keeps every segment
+    void setMaxAge(const double maxAge);
+
+    //! Remove all stored segments
+    void clear(void);
+
+    //! True when a frame for this center begins a new pass over the sweep
+    bool isNewPass(const double centerFreq) const;
+
+    //! Store a frame of power bins (in dB) for a tuned center frequency
+    void update(const std::valarray<float> &bins, const double centerFreq, const double sampleRate, const double time);
+
+    //! The number of stored segments
+    size_t numSegments(void) const
+    {
+        return _segments.size();
+    }
+
+    //! Get the frequency range spanned by the trimmed segments, false when empty
+    bool extent(double &freqLow, double &freqHigh) const;
+
+    //! The number of bins across the trimmed segments at their native resolution
+    size_t numBins(void) const;
+
+    /*!
+     * Resample the stitched segments onto numBins evenly spaced bins from freqLow to freqHigh.
+     * Several input bins under an output bin are reduced with max,
+     * and output bins that are not covered by a segment are set to fill.
+     */
+    std::valarray<float> resample(const double freqLow, const double freqHigh, const size_t numBins, const float fill) const;
+
+private:
+    struct Segment
+    {
+        std::valarray<float> bins;
+        double centerFreq;
+        double sampleRate;
+        double time;
+    };
+
+    //! the usable range of a segment after trimming
+    struct Span
+    {
+        double lo, hi;
+        const Segment *segment;
+    };
+
+    std::vector<Span> spans(void) const;
+
+    double _trim;
+    double _maxAge;
+    std::map<long long, Segment> _segments; //keyed by the center frequency in Hz
+    std::set<long long> _pass; //segments updated in the current pass
+};
@@ -5,13 +5,64 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QComboBox>
-#include <QPainter>
+#include <QImage>
 #include <QPixmap>
 #include <QIcon>
 #include <QAbstractItemView>
-#include <qwt_color_map.h>
+#include <QStyledItemDelegate>
+#include <cstring>
+#include <map>
 #include "GeneratedColorMaps.hpp"
 
+static const QSize COLOR_MAP_ICON_SIZE(100, 20);
+static const int COLOR_MAP_NAME_ROLE = Qt::UserRole+1;
+
+/***********************************************************************
+ * Helpful icons to preview color map:
+ * the color table is written into one scanline and copied to the rest,
+ * and icons are cached for the life of the process
+ **********************************************************************/
+static QIcon makeColorMapIcon(const std::string &name)
+{
+    const auto table = makeColorMapTable(name, size_t(COLOR_MAP_ICON_SIZE.width()));
+    QImage image(COLOR_MAP_ICON_SIZE, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); y++)
+    {
+        std::memcpy(image.scanLine(y), table.data(), table.size()*sizeof(uint32_t));
+    }
+    return QIcon(QPixmap::fromImage(image));
+}
+
+static QIcon cachedColorMapIcon(const std::string &name)
+{
+    //only accessed from the GUI thread
+    static std::map<std::string, QIcon> cache;
+    auto &icon = cache[name];
+    if (icon.isNull()) icon = makeColorMapIcon(name);
+    return icon;
+}
+
+/***********************************************************************
+ * Item delegate that creates icons for the rows as they are painted
+ **********************************************************************/
+class ColorMapEntryDelegate : public QStyledItemDelegate
+{
+public:
+    ColorMapEntryDelegate(QObject *parent):
+        QStyledItemDelegate(parent){}
+
+protected:
+    void initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const
+    {
+        QStyledItemDelegate::initStyleOption(option, index);
+        const auto name = index.data(COLOR_MAP_NAME_ROLE).toString();
+        if (name.isEmpty()) return;
+        option->icon = cachedColorMapIcon(name.toStdString());
+        option->features |= QStyleOptionViewItem::HasDecoration;
+        option->decorationSize = COLOR_MAP_ICON_SIZE;
+    }
+};
+
 /***********************************************************************
  * ComboBox for drop-down entry
  **********************************************************************/
@@ -25,6 +76,7 @@ public:
         connect(this, SIGNAL(currentIndexChanged(const QString &)), this, SLOT(handleWidgetChanged(const QString &)));
         connect(this, SIGNAL(editTextChanged(const QString &)), this, SLOT(handleEntryChanged(const QString &)));
         this->view()->setObjectName("BlockPropertiesEditWidget"); //to pick up eval color style
+        this->setItemDelegate(new ColorMapEntryDelegate(this));
     }
 
 public slots:
@@ -54,6 +106,13 @@ signals:
 private slots:
     void handleWidgetChanged(const QString &)
     {
+        //the popup rows get icons from the delegate, but the closed box shows the item icon
+        const auto index = QComboBox::currentIndex();
+        if (index >= 0 and QComboBox::itemIcon(index).isNull())
+        {
+            const auto name = QComboBox::itemData(index, COLOR_MAP_NAME_ROLE).toString();
+            if (not name.isEmpty()) QComboBox::setItemIcon(index, cachedColorMapIcon(name.toStdString()));
+        }
         emit this->widgetChanged();
     }
     void handleEntryChanged(const QString &)
@@ -62,38 +121,27 @@ private slots:
     }
 };
 
-/***********************************************************************
- * Helpful icons to preview color map
- **********************************************************************/
-static QIcon makeColorMapIcon(const std::string &name)
-{
-    std::unique_ptr<QwtColorMap> colorMap(makeQwtColorMap(name));
-    QPixmap pixmap(100, 20);
-    QPainter painter(&pixmap);
-    painter.setPen(Qt::transparent);
-    const QwtInterval interval(0.0, double(pixmap.width()));
-    for (int i = 0; i < pixmap.width(); i++)
-    {
-        painter.setBrush(QColor(colorMap->rgb(interval, double(i))));
-        painter.drawRect(QRectF(qreal(i), qreal(0), qreal(1), pixmap.height()));
-    }
-    return QIcon(pixmap);
-}
-
 /***********************************************************************
  * Factory function and registration
  **********************************************************************/
 static QWidget *makeColorMapEntry(const QJsonArray &, const QJsonObject &, QWidget *parent)
 {
     auto colorMapEntry =  new ColorMapEntry(parent);
-    colorMapEntry->setIconSize(QSize(100, 20));
+    colorMapEntry->setIconSize(COLOR_MAP_ICON_SIZE);
     for (const auto &pair : availableColorMaps())
     {
+        //icons are created lazily when the rows are displayed
         colorMapEntry->addItem(
-            makeColorMapIcon(pair.second),
             QString::fromStdString(pair.first),
             QString("\"%1\"").arg(QString::fromStdString(pair.second)));
+        colorMapEntry->setItemData(colorMapEntry->count()-1,
+            QString::fromStdString(pair.second), COLOR_MAP_NAME_ROLE);
     }
+
+    //the closed box shows the item icon of the current selection
+    const auto index = colorMapEntry->currentIndex();
+    if (index >= 0) colorMapEntry->setItemIcon(index, cachedColorMapIcon(
+        colorMapEntry->itemData(index, COLOR_MAP_NAME_ROLE).toString().toStdString()));
     return colorMapEntry;
 }
 
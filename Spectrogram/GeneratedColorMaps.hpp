@@ -5,6 +5,7 @@
 #include <vector>
 #include <utility>
 #include <cstddef>
+#include <cstdint>
 
 class QwtColorMap;
 
@@ -16,3 +17,6 @@ std::vector<std::vector<double>> lookupColorMap(const std::string &name);
 
 //! Make a QwtColorMap given the name of a mapping
 QwtColorMap *makeQwtColorMap(const std::string &name);
+
+//! Make a lookup table of ARGB32 colors evenly spaced over a mapping
+std::vector<uint32_t> makeColorMapTable(const std::string &name, const size_t size = 256);
@@ -4,6 +4,8 @@
 #include <Pothos/Exception.hpp>
 #include "GeneratedColorMaps.hpp"
 #include <qwt_color_map.h>
+#include <memory>
+#include <algorithm> //max
 
 static QColor vecToColor(const std::vector<double> &vec)
 {
@@ -24,3 +26,12 @@ QwtColorMap *makeQwtColorMap(const std::string &name)
     }
     return cMap;
 }
+
+std::vector<uint32_t> makeColorMapTable(const std::string &name, const size_t size)
+{
+    std::unique_ptr<QwtColorMap> colorMap(makeQwtColorMap(name));
+    const QwtInterval interval(0.0, double(std::max<size_t>(size, 2)-1));
+    std::vector<uint32_t> table(size);
+    for (size_t i = 0; i < size; i++) table[i] = colorMap->rgb(interval, double(i));
+    return table;
+}
@@ -55,6 +55,7 @@
  * |option [Flat-top] "flattop"
  * |option [Kaiser] "kaiser"
  * |option [Chebyshev] "chebyshev"
+ * |option [Polyphase Filter Bank] "pfb"
  * |preview disable
  * |tab FFT
  *
@@ -62,6 +63,9 @@
  * <ul>
  * <li>When using the <i>Kaiser</i> window, specify [beta] to use the parameterized Kaiser window.</li>
  * <li>When using the <i>Chebyshev</i> window, specify [atten] to use the Dolph-Chebyshev window with attenuation in dB.</li>
+ * <li>When using the <i>Polyphase Filter Bank</i>, specify [taps] per branch (default 4).
+ * Each transform folds taps times the FFT size in samples through a windowed-sinc prototype filter,
+ * for flat-topped bins with much lower leakage than a windowed FFT of the same size.</li>
  * </ul>
  * |default []
  * |preview disable
@@ -109,6 +113,159 @@
  * |preview disable
  * |tab Axis
  *
+ * |param analysisMode[Analysis Mode] How input samples are selected for the transforms.
+ * <ul>
+ * <li>Triggered ("TRIGGERED") transforms periodic snapshots of the input, one set per displayed row.</li>
+ * <li>Streaming ("STREAMING") transforms the entire input every hop size samples,
+ * and folds the transforms into rows with the row reduce mode (FFTs per row is computed automatically).</li>
+ * </ul>
+ * |default "TRIGGERED"
+ * |option [Triggered] "TRIGGERED"
+ * |option [Streaming] "STREAMING"
+ * |preview disable
+ * |tab FFT
+ *
+ * |param hopSize[Hop Size] The number of samples between transforms in streaming mode.
+ * The overlap between transforms is the number of bins minus the hop size.
+ * Zero selects half of the number of bins (50% overlap).
+ * |default 0
+ * |units samples
+ * |widget SpinBox(minimum=0)
+ * |preview disable
+ * |tab FFT
+ *
+ * |param powerOutput[Power Output] Emit the power bins of each transform on an output port.
+ * Every transform is emitted, before the transforms are reduced into rows.
+ * The output packets have the "POWER_BINS" format accepted by the periodogram inputs,
+ * with the "sampleRate" and "centerFreq" of the transformed band in the packet metadata.
+ * In real mode, the packets contain the half spectrum and "halfSpectrum" is set.
+ * Frequency and sample rate labels are forwarded to the output as label messages.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab FFT
+ *
+ * |param zoomAnalysis[Zoom Analysis] Re-analyze the zoomed band at a finer resolution.
+ * When enabled, zooming into a fraction of the input band mixes the zoom center to baseband,
+ * low-pass filters and decimates the input, and transforms the decimated band
+ * with the same number of bins. The rows in the history are resampled onto the zoomed band.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab FFT
+ *
+ * |param fftsPerRow[FFTs per Row] The number of transforms folded into each displayed row.
+ * The trigger rate is increased by this factor so that short bursts between rows are analyzed.
+ * |default 1
+ * |widget SpinBox(minimum=1)
+ * |preview disable
+ * |tab FFT
+ *
+ * |param timeLevels[Time Levels] The number of levels in the multi-resolution time history.
+ * Each level holds a screen of rows and spans twice the time of the level before it,
+ * so the newest level runs at 2^levels - 1 times the rate of rows of a single level.
+ * Rows that age out of a level are decimated by two into the next level
+ * (using the row reduce mode), so that long time spans reflect every transform
+ * and zooming into recent history displays the finer levels.
+ * |default 1
+ * |widget SpinBox(minimum=1, maximum=16)
+ * |preview disable
+ * |tab Axis
+ *
+ * |param rowReduce[Row Reduce] How multiple transforms are folded into a displayed row.
+ * <ul>
+ * <li>Max hold ("MAX") keeps the maximum power of each bin.</li>
+ * <li>Mean power ("MEAN") averages the linear power of each bin.</li>
+ * <li>Peak of N ("PEAK") keeps the transform with the strongest bin.</li>
+ * </ul>
+ * |default "MAX"
+ * |option [Max hold] "MAX"
+ * |option [Mean power] "MEAN"
+ * |option [Peak of N] "PEAK"
+ * |preview disable
+ * |tab FFT
+ *
+ * |param columnReduce[Column Reduce] How FFT bins are reduced when there are more bins than pixel columns.
+ * <ul>
+ * <li>Max ("MAX") displays the strongest bin under each pixel column.</li>
+ * <li>Mean ("MEAN") displays the mean of the bins (in dB) under each pixel column.</li>
+ * </ul>
+ * |default "MAX"
+ * |option [Max] "MAX"
+ * |option [Mean] "MEAN"
+ * |preview disable
+ * |tab Axis
+ *
+ * |param historyFormat[History Format] The storage format for rows in the spectrogram history.
+ * The integer formats store dB values quantized over the history range,
+ * and reduce the memory used by the history by a factor of 2 or 4.
+ * |default "FLOAT32"
+ * |option [Float32] "FLOAT32"
+ * |option [UInt16] "UINT16"
+ * |option [UInt8] "UINT8"
+ * |preview disable
+ * |tab Axis
+ *
+ * |param historyRange[History Range] The [min, max] dB range for quantized history formats.
+ * An empty range tracks the reference level and dynamic range,
+ * and the history is requantized when either one changes.
+ * |default []
+ * |units dB
+ * |preview disable
+ * |tab Axis
+ *
+ * |param recordFile[Record File] Record every displayed row into a memory mapped history file.
+ * The file is a ring of rows with timestamps, center frequency, and sample rate,
+ * so that hours of history cost disk space rather than memory.
+ * An existing recording with the same layout is appended to.
+ * An empty path disables recording.
+ * |default ""
+ * |widget FileEntry(mode=save)
+ * |preview disable
+ * |tab History
+ *
+ * |param recordDepth[Record Depth] The number of rows kept in the record file.
+ * |default 100000
+ * |units rows
+ * |widget SpinBox(minimum=1)
+ * |preview disable
+ * |tab History
+ *
+ * |param paused[Paused] Freeze the displayed rows while recording continues.
+ * |default false
+ * |option [Live] false
+ * |option [Paused] true
+ * |preview disable
+ * |tab History
+ *
+ * |param scrollback[Scrollback] How many seconds back in the recording to display.
+ * A non-zero scrollback freezes the display at that point in the recording.
+ * The mouse wheel also scrubs through the recording.
+ * |default 0.0
+ * |units seconds
+ * |preview disable
+ * |tab History
+ *
+ * |param enableDetector[Enable Detector] Detect regions of energy in the displayed rows.
+ * Bins above an adaptive noise floor are grouped across time and frequency,
+ * bounding boxes are drawn over the plot, and each region is emitted
+ * on the detections signal when it ends. Each detection is a dictionary
+ * with startTime, stopTime (seconds since the epoch), startFreq, stopFreq (Hz),
+ * and peakPower (dB) entries.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab Detector
+ *
+ * |param detectThreshold[Detect Threshold] The power above the noise floor for detection.
+ * |default 10.0
+ * |units dB
+ * |preview disable
+ * |tab Detector
+ *
  * |param enableXAxis[Enable X-Axis] Show or hide the horizontal axis markers.
  * |option [Show] true
  * |option [Hide] false
@@ -129,6 +286,32 @@
  * |preview disable
  * |tab Axis
  *
+ * |param enableSweep[Sweep Mode] Stitch the frames from a retuning radio into a panoramic waterfall.
+ * Frames are stored by the center frequency from the frequency labels,
+ * replacing the previous frame for the same center, and the stitched
+ * segments span the horizontal axis.
+ * One row of the waterfall is added for each pass over the sweep.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab Sweep
+ *
+ * |param sweepTrim[Sweep Trim] The fraction of each segment's band trimmed from each edge.
+ * Trimming removes the filter roll-off at the band edges,
+ * and segments that still overlap are split halfway through the overlap.
+ * |default 0.1
+ * |widget DoubleSpinBox(minimum=0.0, maximum=0.49, step=0.05, decimals=2)
+ * |preview disable
+ * |tab Sweep
+ *
+ * |param sweepMaxAge[Sweep Max Age] Drop segments that have not been updated for this long.
+ * Zero keeps every segment until the sweep is cleared.
+ * |default 0.0
+ * |units seconds
+ * |preview disable
+ * |tab Sweep
+ *
  * |param freqLabelId[Freq Label ID] Labels with this ID can be used to set the center frequency.
  * To ignore frequency labels, set this parameter to an empty string.
  * |default "rxFreq"
@@ -152,6 +335,8 @@
  *
  * |mode graphWidget
  * |factory /plotters/spectrogram(remoteEnv)
+ * |initializer setAnalysisMode(analysisMode)
+ * |initializer enablePowerOutput(powerOutput)
  * |setter setTitle(title)
  * |setter setDisplayRate(displayRate)
  * |setter setSampleRate(sampleRate)
@@ -163,9 +348,26 @@
  * |setter setTimeSpan(timeSpan)
  * |setter setReferenceLevel(refLevel)
  * |setter setDynamicRange(dynRange)
+ * |setter setHopSize(hopSize)
+ * |setter enableZoomAnalysis(zoomAnalysis)
+ * |setter setFFTsPerRow(fftsPerRow)
+ * |setter setRowReduce(rowReduce)
+ * |setter setColumnReduce(columnReduce)
+ * |setter setTimeLevels(timeLevels)
+ * |setter setHistoryFormat(historyFormat)
+ * |setter setHistoryRange(historyRange)
+ * |setter setRecordFile(recordFile)
+ * |setter setRecordDepth(recordDepth)
+ * |setter setPaused(paused)
+ * |setter setScrollback(scrollback)
+ * |setter enableDetector(enableDetector)
+ * |setter setDetectThreshold(detectThreshold)
  * |setter enableXAxis(enableXAxis)
  * |setter enableYAxis(enableYAxis)
  * |setter setColorMap(colorMap)
+ * |setter enableSweep(enableSweep)
+ * |setter setSweepTrim(sweepTrim)
+ * |setter setSweepMaxAge(sweepMaxAge)
  * |setter setFreqLabelId(freqLabelId)
  * |setter setRateLabelId(rateLabelId)
  * |setter setStartLabelId(startLabelId)
@@ -178,7 +380,8 @@ public:
         return new Spectrogram(remoteEnv);
     }
 
-    Spectrogram(const Pothos::ProxyEnvironment::Sptr &remoteEnv)
+    Spectrogram(const Pothos::ProxyEnvironment::Sptr &remoteEnv):
+        _streaming(false)
     {
         _display.reset(new SpectrogramDisplay());
         _display->setName("Display");
@@ -193,6 +396,8 @@ public:
         this->registerCall(this, POTHOS_FCN_TUPLE(Spectrogram, setFreqLabelId));
         this->registerCall(this, POTHOS_FCN_TUPLE(Spectrogram, setRateLabelId));
         this->registerCall(this, POTHOS_FCN_TUPLE(Spectrogram, setStartLabelId));
+        this->registerCall(this, POTHOS_FCN_TUPLE(Spectrogram, setAnalysisMode));
+        this->registerCall(this, POTHOS_FCN_TUPLE(Spectrogram, enablePowerOutput));
 
         //connect to internal display block
         this->connect(this, "setTitle", _display, "setTitle");
@@ -205,15 +410,35 @@ public:
         this->connect(this, "setTimeSpan", _display, "setTimeSpan");
         this->connect(this, "setReferenceLevel", _display, "setReferenceLevel");
         this->connect(this, "setDynamicRange", _display, "setDynamicRange");
+        this->connect(this, "setHopSize", _display, "setHopSize");
+        this->connect(this, "enableZoomAnalysis", _display, "enableZoomAnalysis");
+        this->connect(this, "setFFTsPerRow", _display, "setFFTsPerRow");
+        this->connect(this, "setRowReduce", _display, "setRowReduce");
+        this->connect(this, "setColumnReduce", _display, "setColumnReduce");
+        this->connect(this, "setTimeLevels", _display, "setTimeLevels");
+        this->connect(this, "setHistoryFormat", _display, "setHistoryFormat");
+        this->connect(this, "setHistoryRange", _display, "setHistoryRange");
+        this->connect(this, "setRecordFile", _display, "setRecordFile");
+        this->connect(this, "setRecordDepth", _display, "setRecordDepth");
+        this->connect(this, "setPaused", _display, "setPaused");
+        this->connect(this, "setScrollback", _display, "setScrollback");
+        this->connect(this, "enableDetector", _display, "enableDetector");
+        this->connect(this, "setDetectThreshold", _display, "setDetectThreshold");
         this->connect(this, "enableXAxis", _display, "enableXAxis");
         this->connect(this, "enableYAxis", _display, "enableYAxis");
         this->connect(this, "setColorMap", _display, "setColorMap");
+        this->connect(this, "enableSweep", _display, "enableSweep");
+        this->connect(this, "setSweepTrim", _display, "setSweepTrim");
+        this->connect(this, "setSweepMaxAge", _display, "setSweepMaxAge");
         this->connect(_display, "frequencySelected", this, "frequencySelected");
         this->connect(_display, "relativeFrequencySelected", this, "relativeFrequencySelected");
+        this->connect(_display, "scrollbackChanged", this, "scrollbackChanged");
+        this->connect(_display, "detections", this, "detections");
+        this->connect(_display, "imageExported", this, "imageExported");
 
         //connect to the internal snooper block
         this->connect(_display, "updateRateChanged", _trigger, "setEventRate");
-        this->connect(this, "setNumFFTBins", _trigger, "setNumPoints");
+        this->connect(_display, "numPointsChanged", _trigger, "setNumPoints");
 
         //connect stream ports
         this->connect(this, 0, _trigger, 0);
@@ -239,6 +464,32 @@ public:
         _display->setNumFFTBins(num);
     }
 
+    void setAnalysisMode(const std::string &mode)
+    {
+        _display->setAnalysisMode(mode);
+
+        //streaming mode bypasses the trigger, the display consumes the entire input
+        if (mode == "STREAMING" and not _streaming)
+        {
+            this->disconnect(this, 0, _trigger, 0);
+            this->disconnect(_trigger, 0, _display, 0);
+            this->connect(this, 0, _display, 0);
+        }
+        if (mode == "TRIGGERED" and _streaming)
+        {
+            this->disconnect(this, 0, _display, 0);
+            this->connect(this, 0, _trigger, 0);
+            this->connect(_trigger, 0, _display, 0);
+        }
+        _streaming = (mode == "STREAMING");
+    }
+
+    void enablePowerOutput(const bool enable)
+    {
+        _display->enablePowerOutput(enable);
+        if (enable) this->connect(_display, 0, this, 0);
+    }
+
     void setFreqLabelId(const std::string &id)
     {
         _display->setFreqLabelId(id);
@@ -271,6 +522,7 @@ private:
     Pothos::Proxy _trigger;
     std::shared_ptr<SpectrogramDisplay> _display;
     std::string _freqLabelId, _rateLabelId;
+    bool _streaming;
 };
 
 /***********************************************************************
@@ -0,0 +1,205 @@
+// Copyright (c) 2014-2016 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "SpectrogramDetector.hpp"
+#include <qwt_scale_map.h>
+#include <QPainter>
+#include <algorithm> //min/max
+#include <chrono>
+
+/***********************************************************************
+ * Detector implementation
+ **********************************************************************/
+static const float FLOOR_ALPHA_BELOW = 0.05f;
+static const float FLOOR_ALPHA_ABOVE = 0.001f;
+
+SpectrogramDetector::SpectrogramDetector(void):
+    _threshold(10.0f),
+    _maxGap(2),
+    _rowCount(0)
+{
+    return;
+}
+
+void SpectrogramDetector::setThreshold(const double threshold)
+{
+    _threshold = float(threshold);
+}
+
+void SpectrogramDetector::setMaxGap(const size_t numRows)
+{
+    _maxGap = numRows;
+}
+
+void SpectrogramDetector::reset(void)
+{
+    _noiseFloor.resize(0);
+    _regions.clear();
+    _rowCount = 0;
+}
+
+std::vector<SpectrogramDetection> SpectrogramDetector::feed(const std::valarray<float> &bins, const double time)
+{
+    std::vector<SpectrogramDetection> ended;
+
+    //the first row seeds the noise floor, a size change ends all regions
+    if (bins.size() != _noiseFloor.size())
+    {
+        for (const auto &region : _regions) ended.push_back(region.detection);
+        this->reset();
+        _noiseFloor = bins;
+        return ended;
+    }
+
+    //threshold each bin and adapt the noise floor
+    std::vector<bool> above(bins.size());
+    for (size_t i = 0; i < bins.size(); i++)
+    {
+        above[i] = bins[i] > _noiseFloor[i] + _threshold;
+        _noiseFloor[i] += (above[i]?FLOOR_ALPHA_ABOVE:FLOOR_ALPHA_BELOW)*(bins[i]-_noiseFloor[i]);
+    }
+
+    //group runs of bins above the threshold with the regions they overlap
+    for (size_t lo = 0; lo < bins.size();)
+    {
+        if (not above[lo]){lo++; continue;}
+        size_t hi = lo;
+        float peak = bins[lo];
+        while (hi < bins.size() and above[hi]) peak = std::max(peak, bins[hi++]);
+
+        Region *merged = nullptr;
+        for (auto it = _regions.begin(); it != _regions.end();)
+        {
+            auto &d = it->detection;
+            if (d.hiBin < lo or d.loBin > hi){++it; continue;}
+            if (merged == nullptr)
+            {
+                merged = &*it;
+                ++it;
+                continue;
+            }
+
+            //the run connects two regions: fold this one into the first
+            auto &m = merged->detection;
+            m.startTime = std::min(m.startTime, d.startTime);
+            m.loBin = std::min(m.loBin, d.loBin);
+            m.hiBin = std::max(m.hiBin, d.hiBin);
+            m.peak = std::max(m.peak, d.peak);
+            const auto mergedIndex = merged - _regions.data();
+            it = _regions.erase(it);
+            merged = _regions.data() + mergedIndex;
+        }
+
+        if (merged == nullptr)
+        {
+            Region region;
+            region.detection.startTime = time;
+            region.detection.loBin = lo;
+            region.detection.hiBin = hi;
+            region.detection.numBins = bins.size();
+            region.detection.peak = peak;
+            _regions.push_back(region);
+            merged = &_regions.back();
+        }
+
+        auto &m = merged->detection;
+        m.stopTime = time;
+        m.loBin = std::min(m.loBin, lo);
+        m.hiBin = std::max(m.hiBin, hi);
+        m.peak = std::max(m.peak, peak);
+        merged->lastRow = _rowCount;
+        lo = hi;
+    }
+
+    //end the regions without energy for more than the max gap
+    for (auto it = _regions.begin(); it != _regions.end();)
+    {
+        if (_rowCount - it->lastRow <= _maxGap){++it; continue;}
+        ended.push_back(it->detection);
+        it = _regions.erase(it);
+    }
+    _rowCount++;
+    return ended;
+}
+
+std::vector<SpectrogramDetection> SpectrogramDetector::active(void) const
+{
+    std::vector<SpectrogramDetection> detections;
+    for (const auto &region : _regions) detections.push_back(region.detection);
+    return detections;
+}
+
+/***********************************************************************
+ * Overlay implementation
+ **********************************************************************/
+SpectrogramDetectionsItem::SpectrogramDetectionsItem(void):
+    _xMin(0.0),
+    _xWidth(1.0),
+    _timeScale(1.0),
+    _timeSpan(1.0),
+    _referenceTime(0.0)
+{
+    this->setZ(50.0); //above the spectrogram raster
+}
+
+void SpectrogramDetectionsItem::setFreqAxis(const double xMin, const double xWidth)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _xMin = xMin;
+    _xWidth = xWidth;
+}
+
+void SpectrogramDetectionsItem::setTimeAxis(const double scale, const double span)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _timeScale = scale;
+    _timeSpan = span;
+}
+
+void SpectrogramDetectionsItem::setReferenceTime(const double time)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _referenceTime = time;
+}
+
+void SpectrogramDetectionsItem::update(const std::vector<SpectrogramDetection> &ended, const std::vector<SpectrogramDetection> &active)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _ended.insert(_ended.end(), ended.begin(), ended.end());
+    _active = active;
+
+    //forget detections that scrolled off of the time axis
+    if (_ended.empty()) return;
+    const double oldest = _ended.back().stopTime - 2*_timeSpan;
+    _ended.erase(std::remove_if(_ended.begin(), _ended.end(),
+        [oldest](const SpectrogramDetection &d){return d.stopTime < oldest;}), _ended.end());
+}
+
+void SpectrogramDetectionsItem::clear(void)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _ended.clear();
+    _active.clear();
+}
+
+void SpectrogramDetectionsItem::draw(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    const double now = (_referenceTime != 0.0)?_referenceTime:
+        std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    painter->setPen(QPen(Qt::white, 1.0, Qt::DashLine));
+    painter->setBrush(Qt::NoBrush);
+    const auto drawBox = [&](const SpectrogramDetection &d)
+    {
+        //bins span the frequency axis like the raster columns
+        const double binWidth = _xWidth/std::max<size_t>(d.numBins-1, 1);
+        const double x0 = xMap.transform(_xMin + (d.loBin-0.5)*binWidth);
+        const double x1 = xMap.transform(_xMin + (d.hiBin-0.5)*binWidth);
+        const double y0 = yMap.transform((now-d.stopTime)*_timeScale);
+        const double y1 = yMap.transform((now-d.startTime)*_timeScale);
+        painter->drawRect(QRectF(QPointF(x0, y0), QPointF(x1, y1)).normalized());
+    };
+    for (const auto &d : _ended) drawBox(d);
+    for (const auto &d : _active) drawBox(d);
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2014-2016 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <qwt_plot_item.h>
+#include <valarray>
+#include <vector>
+#include <mutex>
+
+//! A region of energy in the spectrogram
+struct SpectrogramDetection
+{
+    double startTime, stopTime; //!< seconds since the epoch
+    size_t loBin, hiBin; //!< bin range [lo, hi) within the row
+    size_t numBins; //!< the size of the rows
+    float peak; //!< peak power in dB
+};
+
+/*!
+ * Energy detector for spectrogram rows.
+ *
+ * Each bin tracks a noise floor that adapts quickly below the threshold
+ * and slowly above it. Runs of bins above the floor by the threshold
+ * are grouped with overlapping regions from the previous rows,
+ * and a region ends when it has no energy for a number of rows.
+ */
+class SpectrogramDetector
+{
+public:
+    SpectrogramDetector(void);
+
+    //! Set the threshold in dB above the noise floor
+    void setThreshold(const double threshold);
+
+    //! Set the number of rows without energy before a region ends
+    void setMaxGap(const size_t numRows);
+
+    //! Forget the noise floor and the active regions
+    void reset(void);
+
+    //! Feed a row of power bins in dB, returns the regions that ended
+    std::vector<SpectrogramDetection> feed(const std::valarray<float> &bins, const double time);
+
+    //! The regions that are still active
+    std::vector<SpectrogramDetection> active(void) const;
+
+private:
+    struct Region
+    {
+        SpectrogramDetection detection;
+        size_t lastRow;
+    };
+
+    float _threshold;
+    size_t _maxGap;
+    size_t _rowCount;
+    std::valarray<float> _noiseFloor;
+    std::vector<Region> _regions;
+};
+
+/*!
+ * Plot item that draws detection bounding boxes over the raster.
+ * The time axis is measured back from a reference time at y = 0.
+ * Detections are added from the work thread and drawn by the GUI thread.
+ */
+class SpectrogramDetectionsItem : public QwtPlotItem
+{
+public:
+    SpectrogramDetectionsItem(void);
+
+    //! Convert a bin range into the frequency axis
+    void setFreqAxis(const double xMin, const double xWidth);
+
+    //! Seconds to time axis units and the span of the time axis in seconds
+    void setTimeAxis(const double scale, const double span);
+
+    //! The time at y = 0 or zero for the current time
+    void setReferenceTime(const double time);
+
+    //! Add ended detections and replace the active ones
+    void update(const std::vector<SpectrogramDetection> &ended, const std::vector<SpectrogramDetection> &active);
+
+    void clear(void);
+
+    void draw(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect) const;
+
+private:
+    mutable std::mutex _mutex;
+    std::vector<SpectrogramDetection> _ended, _active;
+    double _xMin, _xWidth;
+    double _timeScale, _timeSpan;
+    double _referenceTime;
+};
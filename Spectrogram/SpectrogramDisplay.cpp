@@ -6,8 +6,12 @@
 #include "PothosPlotPicker.hpp"
 #include "PothosPlotter.hpp"
 #include "SpectrogramRaster.hpp"
+#include "SpectrogramRecorder.hpp"
+#include "PothosPlotUtils.hpp"
 #include <QTimer>
 #include <QResizeEvent>
+#include <QWheelEvent>
+#include <QtConcurrent/QtConcurrentRun>
 #include <qwt_plot.h>
 #include <qwt_plot_layout.h>
 #include <qwt_plot_spectrogram.h>
@@ -16,8 +20,10 @@
 #include <qwt_color_map.h>
 #include <qwt_legend.h>
 #include <QHBoxLayout>
+#include <Pothos/Object/Containers.hpp>
 #include <iostream>
 #include <algorithm> //min/max
+#include <chrono>
 
 SpectrogramDisplay::SpectrogramDisplay(void):
     _replotTimer(new QTimer(this)),
@@ -25,6 +31,7 @@ SpectrogramDisplay::SpectrogramDisplay(void):
     _plotSpect(new QwtPlotSpectrogram()),
     _plotRaster(new MySpectrogramRasterData()),
     _lastUpdateRate(1.0),
+    _lastNumPoints(0),
     _displayRate(1.0),
     _sampleRate(1.0),
     _sampleRateWoAxisUnits(1.0),
@@ -32,8 +39,28 @@ SpectrogramDisplay::SpectrogramDisplay(void):
     _centerFreqWoAxisUnits(0.0),
     _numBins(1024),
     _timeSpan(10.0),
+    _timeLevels(1),
     _refLevel(0.0),
     _dynRange(100.0),
+    _recordDepth(100000),
+    _paused(false),
+    _scrollback(0.0),
+    _frozenTime(0.0),
+    _detectorEnabled(false),
+    _detectionsItem(new SpectrogramDetectionsItem()),
+    _zoomAnalysis(false),
+    _sweepEnabled(false),
+    _sweepReset(false),
+    _sweepLayout(false),
+    _sweepTrim(0.1),
+    _sweepMaxAge(0.0),
+    _sweepLow(0.0),
+    _sweepHigh(0.0),
+    _sweepCols(0),
+    _streamingMode(false),
+    _hopSize(0),
+    _streamSkip(0),
+    _powerOutput(false),
     _fullScale(1.0),
     _fftModeComplex(true),
     _fftModeAutomatic(true),
@@ -53,12 +80,38 @@ SpectrogramDisplay::SpectrogramDisplay(void):
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setTimeSpan));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setReferenceLevel));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setDynamicRange));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setFFTsPerRow));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setRowReduce));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setColumnReduce));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setTimeLevels));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setHistoryFormat));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setHistoryRange));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setRecordFile));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setRecordDepth));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setPaused));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setScrollback));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, recordedTimeSpan));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setAnalysisMode));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setHopSize));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, hopSize));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, enableDetector));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setDetectThreshold));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, enablePowerOutput));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, exportImage));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, enableZoomAnalysis));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, enableSweep));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setSweepTrim));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, setSweepMaxAge));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, title));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, displayRate));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, sampleRate));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, centerFrequency));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, numFFTBins));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, timeSpan));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, fftsPerRow));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, timeLevels));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, paused));
+    this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, scrollback));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, referenceLevel));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, dynamicRange));
     this->registerCall(this, POTHOS_FCN_TUPLE(SpectrogramDisplay, enableXAxis));
@@ -69,7 +122,12 @@ SpectrogramDisplay::SpectrogramDisplay(void):
     this->registerSignal("frequencySelected");
     this->registerSignal("relativeFrequencySelected");
     this->registerSignal("updateRateChanged");
+    this->registerSignal("scrollbackChanged");
+    this->registerSignal("detections");
+    this->registerSignal("imageExported");
+    this->registerSignal("numPointsChanged");
     this->setupInput(0);
+    this->setupOutput(0);
 
     //layout
     auto layout = new QHBoxLayout(this);
@@ -86,6 +144,7 @@ SpectrogramDisplay::SpectrogramDisplay(void):
         _mainPlot->plotLayout()->setAlignCanvasToScales(true);
         _mainPlot->enableAxis(QwtPlot::yRight);
         _mainPlot->axisWidget(QwtPlot::yRight)->setColorBarEnabled(true);
+        _mainPlot->canvas()->installEventFilter(this);
     }
 
     //setup spectrogram plot item
@@ -96,12 +155,23 @@ SpectrogramDisplay::SpectrogramDisplay(void):
         _plotSpect->setRenderThreadCount(0); //enable multi-thread
     }
 
+    //setup detection overlay
+    {
+        _detectionsItem->attach(_mainPlot);
+        _detectionsItem->setVisible(false);
+    }
+
     connect(_replotTimer, SIGNAL(timeout(void)), _mainPlot, SLOT(replot(void)));
 }
 
 SpectrogramDisplay::~SpectrogramDisplay(void)
 {
-    return;
+    _exportFuture.waitForFinished();
+}
+
+QwtPlotZoomer *SpectrogramDisplay::zoomer(void) const
+{
+    return _mainPlot->zoomer();
 }
 
 void SpectrogramDisplay::setTitle(const QString &title)
@@ -130,7 +200,13 @@ void SpectrogramDisplay::setCenterFrequency(const double freq)
 void SpectrogramDisplay::setNumFFTBins(const size_t numBins)
 {
     _numBins = numBins;
-    _plotRaster->setNumColumns(numBins);
+    if (not _sweepEnabled) _plotRaster->setNumColumns(numBins);
+    _streamSamps.clear();
+    _streamSkip = 0;
+
+    //records keep their own size, a new recording is only needed for larger rows
+    const auto recorder = std::atomic_load(&_recorder);
+    if (recorder and recorder->maxBins() < numBins) this->updateRecorder();
 }
 
 void SpectrogramDisplay::setWindowType(const std::string &windowType, const std::vector<double> &windowArgs)
@@ -160,6 +236,88 @@ void SpectrogramDisplay::setTimeSpan(const double timeSpan)
     QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
 }
 
+void SpectrogramDisplay::setAnalysisMode(const std::string &mode)
+{
+    if (mode == "TRIGGERED"){}
+    else if (mode == "STREAMING"){}
+    else throw Pothos::InvalidArgumentException("SpectrogramDisplay::setAnalysisMode("+mode+")", "unknown mode");
+    _streamingMode = (mode == "STREAMING");
+}
+
+void SpectrogramDisplay::setHopSize(const size_t hopSize)
+{
+    _hopSize = hopSize;
+}
+
+void SpectrogramDisplay::enableDetector(const bool enable)
+{
+    _detectorEnabled = enable;
+    _detector.reset();
+    _detectionsItem->clear();
+    QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+}
+
+void SpectrogramDisplay::setDetectThreshold(const double threshold)
+{
+    _detector.setThreshold(threshold);
+}
+
+void SpectrogramDisplay::enablePowerOutput(const bool enable)
+{
+    _powerOutput = enable;
+}
+
+void SpectrogramDisplay::enableZoomAnalysis(const bool enable)
+{
+    _zoomAnalysis = enable;
+    QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+}
+
+void SpectrogramDisplay::enableSweep(const bool enable)
+{
+    _sweepEnabled = enable;
+    _sweepReset = true;
+    _sweepLow = _sweepHigh = 0.0;
+    _sweepCols = 0;
+    _plotRaster->setNumColumns(_numBins);
+    QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+}
+
+void SpectrogramDisplay::setSweepTrim(const double trim)
+{
+    if (trim < 0.0 or trim >= 0.5) throw Pothos::RangeException(
+        "SpectrogramDisplay::setSweepTrim("+std::to_string(trim)+")",
+        "trim must be in [0.0, 0.5)");
+    _sweepTrim = trim;
+}
+
+void SpectrogramDisplay::setSweepMaxAge(const double maxAge)
+{
+    _sweepMaxAge = maxAge;
+}
+
+void SpectrogramDisplay::setFFTsPerRow(const size_t numPerRow)
+{
+    _rowReducer.setNumPerRow(numPerRow);
+}
+
+void SpectrogramDisplay::setRowReduce(const std::string &mode)
+{
+    _rowReducer.setMode(mode);
+    _plotRaster->setTimeReduce(mode);
+}
+
+void SpectrogramDisplay::setColumnReduce(const std::string &mode)
+{
+    _plotRaster->setColumnReduce(mode);
+}
+
+void SpectrogramDisplay::setTimeLevels(const size_t numLevels)
+{
+    _plotRaster->setNumLevels(numLevels);
+    _timeLevels = numLevels;
+}
+
 QString SpectrogramDisplay::title(void) const
 {
     return _mainPlot->title().text();
@@ -168,52 +326,240 @@ QString SpectrogramDisplay::title(void) const
 void SpectrogramDisplay::setReferenceLevel(const double refLevel)
 {
     _refLevel = refLevel;
+    this->updateHistoryRange();
     QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
 }
 
 void SpectrogramDisplay::setDynamicRange(const double dynRange)
 {
     _dynRange = dynRange;
+    this->updateHistoryRange();
     QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
 }
 
-void SpectrogramDisplay::handleUpdateAxis(void)
+void SpectrogramDisplay::setHistoryFormat(const std::string &format)
 {
-    QString timeAxisTitle("secs");
-    if (_timeSpan <= 100e-9)
+    _plotRaster->setStorageFormat(format);
+}
+
+void SpectrogramDisplay::setHistoryRange(const std::vector<double> &range)
+{
+    if (not range.empty() and range.size() != 2) throw Pothos::RangeException("SpectrogramDisplay::setHistoryRange()", "range vector must be empty or size 2");
+    _historyRange = range;
+    this->updateHistoryRange();
+}
+
+void SpectrogramDisplay::updateHistoryRange(void)
+{
+    //a fixed range, otherwise track the displayed range
+    if (_historyRange.size() == 2) _plotRaster->setStorageRange(_historyRange[0], _historyRange[1]);
+    else _plotRaster->setStorageRange(_refLevel-_dynRange, _refLevel);
+}
+
+void SpectrogramDisplay::setRecordFile(const std::string &path)
+{
+    _recordFile = path;
+    this->updateRecorder();
+}
+
+void SpectrogramDisplay::setRecordDepth(const size_t depth)
+{
+    if (depth == 0) throw Pothos::RangeException("SpectrogramDisplay::setRecordDepth()", "depth must be at least one row");
+    _recordDepth = depth;
+    this->updateRecorder();
+}
+
+void SpectrogramDisplay::updateRecorder(void)
+{
+    //release the old file before re-opening the same path
+    std::atomic_store(&_recorder, std::shared_ptr<SpectrogramRecorder>());
+    if (_recordFile.empty()) return;
+    std::atomic_store(&_recorder, std::make_shared<SpectrogramRecorder>(
+        QString::fromStdString(_recordFile), _numBins, _recordDepth));
+}
+
+void SpectrogramDisplay::setPaused(const bool paused)
+{
+    _paused = paused;
+    QMetaObject::invokeMethod(this, "handleUpdateHistoryView", Qt::QueuedConnection);
+}
+
+void SpectrogramDisplay::setScrollback(const double scrollback)
+{
+    _scrollback.store(std::max(scrollback, 0.0));
+    QMetaObject::invokeMethod(this, "handleUpdateHistoryView", Qt::QueuedConnection);
+}
+
+double SpectrogramDisplay::recordedTimeSpan(void) const
+{
+    const auto recorder = std::atomic_load(&_recorder);
+    if (not recorder or recorder->size() == 0) return 0.0;
+    return recorder->timeAt(0) - recorder->timeAt(recorder->size()-1);
+}
+
+void SpectrogramDisplay::handleUpdateHistoryView(void)
+{
+    //live view: rows are displayed as they arrive
+    const double scrollback = _scrollback.load();
+    if (not _paused and scrollback <= 0.0)
     {
-        _timeSpan *= 1e9;
-        timeAxisTitle = "nsecs";
+        _frozenTime = 0.0;
+        _plotRaster->setFrozen(false);
+        _detectionsItem->setReferenceTime(0.0);
+        return;
     }
-    else if (_timeSpan <= 100e-6)
+
+    //without a recording, the view is frozen at the live history
+    const auto recorder = std::atomic_load(&_recorder);
+    if (not recorder or recorder->size() == 0)
     {
-        _timeSpan *= 1e6;
-        timeAxisTitle = "usecs";
+        if (_frozenTime == 0.0) _frozenTime = std::chrono::duration<double>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        _plotRaster->setFrozen(true);
+        _detectionsItem->setReferenceTime(_frozenTime);
+        return;
     }
-    else if (_timeSpan <= 100e-3)
+
+    //scrollback is relative to the newest row when the view was frozen
+    if (_frozenTime == 0.0) _frozenTime = recorder->timeAt(0);
+    _detectionsItem->setReferenceTime(_frozenTime - scrollback);
+
+    //page in one recorded row per pixel row over the visible time span,
+    //rows that span several pixel rows are only read once,
+    //and each row is resampled from its recorded band onto the displayed band
+    const double toAxis = _sampleRateWoAxisUnits/_sampleRate;
+    const size_t numPixelRows = size_t(std::max(_mainPlot->canvas()->height(), 1));
+    const double newest = _frozenTime - scrollback;
+    std::vector<MySpectrogramRasterData::RowPtr> rows;
+    MySpectrogramRasterData::RowPtr row, emptyRow;
+    SpectrogramRecorder::Record record;
+    size_t lastAge = ~size_t(0);
+    for (size_t p = 0; p < numPixelRows; p++)
     {
-        _timeSpan *= 1e3;
-        timeAxisTitle = "msecs";
+        const size_t age = recorder->ageAtTime(newest - (p*_timeSpan)/numPixelRows);
+        if (age == lastAge) {}
+        else if (recorder->read(age, record))
+        {
+            const double freqLow = record.half?0.0:(record.centerFreq-record.sampleRate/2);
+            const QwtInterval interval(freqLow*toAxis, (record.centerFreq+record.sampleRate/2)*toAxis);
+            row = _plotRaster->createRow(record.bins, interval);
+        }
+        else
+        {
+            //before the start of the recording
+            if (not emptyRow) emptyRow = _plotRaster->createRow(std::valarray<float>(-1000.0f, _numBins));
+            row = emptyRow;
+        }
+        lastAge = age;
+        rows.push_back(row);
     }
-    _mainPlot->setAxisTitle(QwtPlot::yLeft, timeAxisTitle);
+    _plotRaster->setFrozenRows(rows);
+}
 
-    QString freqAxisTitle("Hz");
-    double factor = std::max(_sampleRate, _centerFreq);
-    if (factor >= 2e9)
+void SpectrogramDisplay::exportImage(const std::string &path, const int width, const int height)
+{
+    if (path.empty()) throw Pothos::InvalidArgumentException("SpectrogramDisplay::exportImage()", "empty path");
+    if (width <= 0 or height <= 0) throw Pothos::RangeException("SpectrogramDisplay::exportImage()", "size must be positive");
+    QMetaObject::invokeMethod(this, "handleExportImage", Qt::QueuedConnection,
+        Q_ARG(QString, QString::fromStdString(path)), Q_ARG(int, width), Q_ARG(int, height));
+}
+
+void SpectrogramDisplay::handleExportImage(const QString &path, const int width, const int height)
+{
+    //one export at a time, the GUI thread does not wait on the render
+    if (_exportFuture.isRunning()) return this->handleImageExported(path, false);
+
+    //capture the current zoom and color settings in the GUI thread
+    const auto xInterval = _mainPlot->axisInterval(QwtPlot::xBottom);
+    const auto yInterval = _mainPlot->axisInterval(QwtPlot::yLeft);
+    const QRectF area(xInterval.minValue(), yInterval.minValue(), xInterval.width(), yInterval.width());
+    const auto range = _plotRaster->interval(Qt::ZAxis);
+    const auto colorTable = makeColorMapTable(_colorMapName);
+
+    //render from a snapshot of the history in the background
+    auto raster = _plotRaster;
+    _exportFuture = QtConcurrent::run([=](void)
     {
-        factor = 1e9;
-        freqAxisTitle = "GHz";
+        bool ok = false;
+        if (path.endsWith(".npy", Qt::CaseInsensitive))
+        {
+            size_t numCols = 0;
+            const auto rows = raster->renderRows(area, size_t(height), numCols);
+            ok = writeNumpyFloat32(path, size_t(height), numCols, rows.data());
+        }
+        else ok = raster->renderImage(area, QSize(width, height), colorTable, range).save(path);
+        QMetaObject::invokeMethod(this, "handleImageExported", Qt::QueuedConnection, Q_ARG(QString, path), Q_ARG(bool, ok));
+    });
+}
+
+void SpectrogramDisplay::handleImageExported(const QString &path, const bool ok)
+{
+    this->emitSignal("imageExported", path.toStdString(), ok);
+}
+
+bool SpectrogramDisplay::eventFilter(QObject *obj, QEvent *event)
+{
+    //the mouse wheel scrubs through the recording in tenths of the time span
+    if (obj == _mainPlot->canvas() and event->type() == QEvent::Wheel and std::atomic_load(&_recorder))
+    {
+        const auto wheel = static_cast<QWheelEvent *>(event);
+        const double steps = wheel->angleDelta().y()/120.0;
+        const double scrollback = std::min(std::max(_scrollback.load() + steps*_timeSpan/10, 0.0), this->recordedTimeSpan());
+        _scrollback.store(scrollback);
+        this->handleUpdateHistoryView();
+        this->emitSignal("scrollbackChanged", scrollback);
+        return true;
+    }
+    return QWidget::eventFilter(obj, event);
+}
+
+double SpectrogramDisplay::freqAxisFactor(const double maxFreq, QString &title)
+{
+    title = "Hz";
+    if (maxFreq >= 2e9)
+    {
+        title = "GHz";
+        return 1e9;
+    }
+    if (maxFreq >= 2e6)
+    {
+        title = "MHz";
+        return 1e6;
     }
-    else if (factor >= 2e6)
+    if (maxFreq >= 2e3)
     {
-        factor = 1e6;
-        freqAxisTitle = "MHz";
+        title = "kHz";
+        return 1e3;
     }
-    else if (factor >= 2e3)
+    return 1.0;
+}
+
+void SpectrogramDisplay::handleUpdateAxis(void)
+{
+    //the time span in the units of the axis
+    double timeSpan = _timeSpan;
+    QString timeAxisTitle("secs");
+    if (timeSpan <= 100e-9)
     {
-        factor = 1e3;
-        freqAxisTitle = "kHz";
+        timeSpan *= 1e9;
+        timeAxisTitle = "nsecs";
     }
+    else if (timeSpan <= 100e-6)
+    {
+        timeSpan *= 1e6;
+        timeAxisTitle = "usecs";
+    }
+    else if (timeSpan <= 100e-3)
+    {
+        timeSpan *= 1e3;
+        timeAxisTitle = "msecs";
+    }
+    _mainPlot->setAxisTitle(QwtPlot::yLeft, timeAxisTitle);
+
+    //in sweep mode the axis spans the stitched segments
+    const bool sweep = _sweepEnabled and _sweepHigh > _sweepLow;
+    QString freqAxisTitle;
+    const double factor = freqAxisFactor(sweep?std::max(_sweepHigh-_sweepLow, _sweepHigh):std::max(_sampleRate, _centerFreq), freqAxisTitle);
     _mainPlot->setAxisTitle(QwtPlot::xBottom, freqAxisTitle);
 
     _mainPlot->zoomer()->setAxis(QwtPlot::xBottom, QwtPlot::yLeft);
@@ -223,15 +569,29 @@ void SpectrogramDisplay::handleUpdateAxis(void)
 
     //update main plot axis
     const qreal freqLow = _fftModeComplex?(_centerFreqWoAxisUnits-_sampleRateWoAxisUnits/2):0.0;
-    _mainPlot->setAxisScale(QwtPlot::xBottom, freqLow, _centerFreqWoAxisUnits+_sampleRateWoAxisUnits/2);
-    _mainPlot->setAxisScale(QwtPlot::yLeft, 0, _timeSpan);
+    if (sweep) _mainPlot->setAxisScale(QwtPlot::xBottom, _sweepLow/factor, _sweepHigh/factor);
+    else _mainPlot->setAxisScale(QwtPlot::xBottom, freqLow, _centerFreqWoAxisUnits+_sampleRateWoAxisUnits/2);
+    _mainPlot->setAxisScale(QwtPlot::yLeft, 0, timeSpan);
     _mainPlot->setAxisScale(QwtPlot::yRight, _refLevel-_dynRange, _refLevel);
 
     _mainPlot->updateAxes(); //update after axis changes before setting raster
-    _plotRaster->setInterval(Qt::XAxis, _mainPlot->axisInterval(QwtPlot::xBottom));
+
+    //the zoom is reset with the axis, and the history is resampled back onto the full band,
+    //or back onto the input band after a sweep, by the work thread before its next row;
+    //stitched rows always contain the full spectrum and their layout is set by the work thread
+    const auto xInterval = _mainPlot->axisInterval(QwtPlot::xBottom);
+    const bool zoomed = bool(std::atomic_load(&_freqZoom));
+    if (not sweep) _plotRaster->postRowInterval(xInterval, _fftModeComplex, zoomed or _sweepLayout);
+    _sweepLayout = sweep;
+    if (zoomed) std::atomic_store(&_freqZoom, std::shared_ptr<FrequencyZoom>());
+
+    _plotRaster->setInterval(Qt::XAxis, xInterval);
     _plotRaster->setInterval(Qt::YAxis, _mainPlot->axisInterval(QwtPlot::yLeft));
     _plotRaster->setInterval(Qt::ZAxis, _mainPlot->axisInterval(QwtPlot::yRight));
-    _plotRaster->setFFTMode(_fftModeComplex);
+    _plotRaster->setFFTMode(sweep or _fftModeComplex);
+    _detectionsItem->setFreqAxis(xInterval.minValue(), xInterval.width());
+    _detectionsItem->setTimeAxis(timeSpan/_timeSpan, _timeSpan);
+    _detectionsItem->setVisible(_detectorEnabled);
     _plotSpect->setColorMap(makeQwtColorMap(_colorMapName));
     _mainPlot->axisWidget(QwtPlot::yRight)->setColorMap(_plotRaster->interval(Qt::ZAxis), makeQwtColorMap(_colorMapName));
 
@@ -258,9 +618,51 @@ void SpectrogramDisplay::restoreState(const QVariant &state)
     _mainPlot->setState(state);
 }
 
-void SpectrogramDisplay::handleZoomed(const QRectF &)
+void SpectrogramDisplay::handleZoomed(const QRectF &rect)
+{
+    //the zoomed band in Hz, limited to the input band
+    const auto base = _mainPlot->zoomer()->zoomBase();
+    const double toHz = _sampleRate/_sampleRateWoAxisUnits;
+    const double lo = std::max(rect.left(), base.left())*toHz;
+    const double hi = std::min(rect.right(), base.right())*toHz;
+
+    const size_t decim = FrequencyZoom::decimationFor(_sampleRate, hi-lo);
+    if (not _zoomAnalysis or _sweepEnabled or rect == base or decim < 2)
+    {
+        return this->setZoomAnalysis(std::shared_ptr<FrequencyZoom>());
+    }
+
+    std::shared_ptr<FrequencyZoom> zoom(new FrequencyZoom());
+    zoom->configure((lo+hi)/2 - _centerFreq, _sampleRate, decim);
+    this->setZoomAnalysis(zoom);
+}
+
+void SpectrogramDisplay::setZoomAnalysis(const std::shared_ptr<FrequencyZoom> &zoom)
+{
+    if (not zoom and not std::atomic_load(&_freqZoom)) return;
+
+    //rows from the zoom analysis span the decimated band around the zoom center,
+    //the history is resampled so that older rows line up with the new rows,
+    //the resample is queued before the zoom so that it precedes the first zoomed row
+    const auto base = _mainPlot->zoomer()->zoomBase();
+    QwtInterval interval(base.left(), base.right());
+    if (zoom)
+    {
+        const double toAxis = _sampleRateWoAxisUnits/_sampleRate;
+        const double center = (_centerFreq + zoom->offset())*toAxis;
+        const double width = zoom->outputRate()*toAxis;
+        interval = QwtInterval(center-width/2, center+width/2);
+    }
+    _plotRaster->postRowInterval(interval, zoom or _fftModeComplex);
+    _plotRaster->setInterval(Qt::XAxis, interval);
+    _detectionsItem->setFreqAxis(interval.minValue(), interval.width());
+    std::atomic_store(&_freqZoom, zoom);
+}
+
+size_t SpectrogramDisplay::numInputPoints(const std::shared_ptr<FrequencyZoom> &zoom) const
 {
-    return;
+    const size_t numInput = _fftPowerSpectrum.inputSize(_numBins);
+    return zoom?zoom->inputSize(numInput):numInput;
 }
 
 void SpectrogramDisplay::handlePickerSelected(const QPointF &p)
@@ -272,7 +674,63 @@ void SpectrogramDisplay::handlePickerSelected(const QPointF &p)
 
 void SpectrogramDisplay::appendBins(const std::valarray<float> &bins)
 {
+    const double time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    //rows from the zoom analysis span the decimated band around the zoom center
+    const double centerFreq = _workZoom?(_centerFreq + _workZoom->offset()):_centerFreq;
+    const double sampleRate = _workZoom?_workZoom->outputRate():_sampleRate;
+
+    //the recording keeps the rows as they were captured
+    const auto recorder = std::atomic_load(&_recorder);
+    if (recorder)
+    {
+        SpectrogramRecorder::Record record;
+        record.time = time;
+        record.centerFreq = centerFreq;
+        record.sampleRate = sampleRate;
+        record.half = not (_workZoom or _fftModeComplex or _sweepEnabled);
+        record.bins = bins;
+        recorder->append(record);
+    }
+
+    if (_sweepEnabled) return this->appendSweep(bins, time, centerFreq, sampleRate);
+
     _plotRaster->appendBins(bins);
+    const double freqLow = (_workZoom or _fftModeComplex)?(centerFreq-sampleRate/2):0.0;
+    if (_detectorEnabled) this->detectBins(bins, time, freqLow, centerFreq+sampleRate/2-freqLow);
+}
+
+void SpectrogramDisplay::appendSweep(const std::valarray<float> &bins, const double time, const double centerFreq, const double sampleRate)
+{
+    if (_sweepReset) _sweep.clear();
+    _sweepReset = false;
+    _sweep.setTrim(_sweepTrim);
+    _sweep.setMaxAge(_sweepMaxAge);
+
+    //a frame for a center that was already updated completes a pass,
+    //and the completed pass is stitched into a single row of the waterfall
+    double lo = 0.0, hi = 0.0;
+    if (_sweep.isNewPass(centerFreq) and _sweep.extent(lo, hi))
+    {
+        //resample the history before appending rows with the new layout,
+        //the x interval of the raster is updated with the axis in the GUI thread
+        const size_t numCols = std::min<size_t>(std::max<size_t>(_sweep.numBins(), 2), 1 << 16);
+        if (lo != _sweepLow or hi != _sweepHigh or numCols != _sweepCols)
+        {
+            QString title;
+            const double factor = freqAxisFactor(std::max(hi-lo, hi), title);
+            _plotRaster->setNumColumns(numCols);
+            _plotRaster->setRowInterval(QwtInterval(lo/factor, hi/factor), true);
+            _sweepLow = lo;
+            _sweepHigh = hi;
+            _sweepCols = numCols;
+            QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+        }
+        const auto row = _sweep.resample(lo, hi, numCols, -1000.0f);
+        _plotRaster->appendBins(row);
+        if (_detectorEnabled) this->detectBins(row, time, lo, hi-lo);
+    }
+    _sweep.update(bins, centerFreq, sampleRate, time);
 }
 
 void SpectrogramDisplay::setColorMap(const std::string &colorMapName)
@@ -280,3 +738,25 @@ void SpectrogramDisplay::setColorMap(const std::string &colorMapName)
     _colorMapName = colorMapName;
     QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
 }
+
+void SpectrogramDisplay::detectBins(const std::valarray<float> &bins, const double time, const double freqLow, const double freqWidth)
+{
+    const auto ended = _detector.feed(bins, time);
+    _detectionsItem->update(ended, _detector.active());
+    if (ended.empty()) return;
+
+    //bins span the frequency axis like the raster columns
+    Pothos::ObjectVector detections;
+    for (const auto &d : ended)
+    {
+        const double binWidth = freqWidth/std::max<size_t>(d.numBins-1, 1);
+        Pothos::ObjectKwargs detection;
+        detection["startTime"] = Pothos::Object(d.startTime);
+        detection["stopTime"] = Pothos::Object(d.stopTime);
+        detection["startFreq"] = Pothos::Object(freqLow + d.loBin*binWidth);
+        detection["stopFreq"] = Pothos::Object(freqLow + (d.hiBin-1)*binWidth);
+        detection["peakPower"] = Pothos::Object(double(d.peak));
+        detections.push_back(Pothos::Object(detection));
+    }
+    this->emitSignal("detections", detections);
+}
@@ -6,16 +6,23 @@
 #include <Pothos/Framework.hpp>
 #include <QVariant>
 #include <QWidget>
+#include <QFuture>
 #include <memory>
 #include <map>
 #include <vector>
+#include <atomic>
 #include "PothosPlotterFFTUtils.hpp"
+#include "SpectrogramRowReducer.hpp"
+#include "SpectrogramDetector.hpp"
+#include "PothosSweepStitcher.hpp"
 
 class QTimer;
 class PothosPlotter;
 class QwtColorMap;
 class QwtPlotSpectrogram;
+class QwtPlotZoomer;
 class MySpectrogramRasterData;
+class SpectrogramRecorder;
 
 class SpectrogramDisplay : public QWidget, public Pothos::Block
 {
@@ -31,6 +38,9 @@ public:
         return this;
     }
 
+    //! The zoomer of the plot, used to link the frequency axis with another plotter
+    QwtPlotZoomer *zoomer(void) const;
+
     //! set the plotter's title
     void setTitle(const QString &title);
 
@@ -58,6 +68,60 @@ public:
     void setTimeSpan(const double timeSpan);
     void setReferenceLevel(const double refLevel);
     void setDynamicRange(const double dynRange);
+    void setFFTsPerRow(const size_t numPerRow);
+    void setRowReduce(const std::string &mode);
+    void setColumnReduce(const std::string &mode);
+    void setTimeLevels(const size_t numLevels);
+    void setHistoryFormat(const std::string &format);
+    void setHistoryRange(const std::vector<double> &range);
+    void setRecordFile(const std::string &path);
+    void setRecordDepth(const size_t depth);
+    void setPaused(const bool paused);
+    void setScrollback(const double scrollback);
+    void setAnalysisMode(const std::string &mode);
+    void setHopSize(const size_t hopSize);
+    void enableDetector(const bool enable);
+    void setDetectThreshold(const double threshold);
+
+    /*!
+     * Emit the power bins of each transform on output port 0.
+     * The packets have the "POWER_BINS" format accepted by the periodogram,
+     * with the "index", "sampleRate", "centerFreq", and "halfSpectrum" in the metadata.
+     * Frequency and sample rate labels are forwarded as label messages.
+     */
+    void enablePowerOutput(const bool enable);
+
+    /*!
+     * Re-analyze the zoomed band at a finer resolution.
+     * When the zoom covers a fraction of the input band, the input is mixed
+     * to the zoom center, decimated, and transformed at the same FFT size.
+     */
+    void enableZoomAnalysis(const bool enable);
+
+    /*!
+     * Stitch the frames from a retuning radio into a panoramic waterfall.
+     * Frames are stored by the center frequency from the frequency labels,
+     * and one row is added to the history for each pass over the sweep.
+     */
+    void enableSweep(const bool enable);
+
+    //! The fraction of each segment's band trimmed from each edge
+    void setSweepTrim(const double trim);
+
+    //! Drop sweep segments that are not updated for this many seconds (0 keeps them)
+    void setSweepMaxAge(const double maxAge);
+
+    /*!
+     * Export the displayed history and zoom in the background.
+     * Paths ending in .npy export the power bins in dB at full bin resolution
+     * with one row per output row (the width is ignored), otherwise the
+     * image format is determined by the file extension.
+     * An export that is requested while another is in progress fails.
+     */
+    void exportImage(const std::string &path, const int width, const int height);
+
+    //! The number of seconds available in the recording file
+    double recordedTimeSpan(void) const;
 
     QString title(void) const;
 
@@ -86,6 +150,32 @@ public:
         return _timeSpan;
     }
 
+    size_t fftsPerRow(void) const
+    {
+        return _rowReducer.numPerRow();
+    }
+
+    size_t timeLevels(void) const
+    {
+        return _timeLevels;
+    }
+
+    //! The number of samples between transforms in streaming mode
+    size_t hopSize(void) const
+    {
+        return (_hopSize == 0)?std::max<size_t>(_numBins/2, 1):_hopSize;
+    }
+
+    bool paused(void) const
+    {
+        return _paused;
+    }
+
+    double scrollback(void) const
+    {
+        return _scrollback.load();
+    }
+
     double referenceLevel(void) const
     {
         return _refLevel;
@@ -125,6 +215,9 @@ public:
         return this->minimumSizeHint();
     }
 
+    //mouse wheel scrubbing through the recording
+    bool eventFilter(QObject *obj, QEvent *event);
+
 public slots:
 
     QVariant saveState(void) const;
@@ -136,14 +229,32 @@ private slots:
     void handlePickerSelected(const QPointF &);
     void appendBins(const std::valarray<float> &bins);
     void handleUpdateAxis(void);
+    void handleUpdateHistoryView(void);
+    void handleExportImage(const QString &path, const int width, const int height);
+    void handleImageExported(const QString &path, const bool ok);
 
 private:
+    void updateHistoryRange(void);
+    void updateRecorder(void);
+    void handleLabel(const Pothos::Label &label);
+    void handleInputType(const Pothos::DType &dtype);
+    void workStreaming(void);
+    std::valarray<float> transformBins(CArray &fftBins, const bool halfSpectrum);
+    void detectBins(const std::valarray<float> &bins, const double time, const double freqLow, const double freqWidth);
+    void setZoomAnalysis(const std::shared_ptr<FrequencyZoom> &zoom);
+    size_t numInputPoints(const std::shared_ptr<FrequencyZoom> &zoom) const;
+    bool updateWorkZoom(void);
+    void appendSweep(const std::valarray<float> &bins, const double time, const double centerFreq, const double sampleRate);
+    static double freqAxisFactor(const double maxFreq, QString &title);
+
     QTimer *_replotTimer;
     PothosPlotter *_mainPlot;
     std::unique_ptr<QwtPlotSpectrogram> _plotSpect;
     MySpectrogramRasterData *_plotRaster;
     FFTPowerSpectrum _fftPowerSpectrum;
+    SpectrogramRowReducer _rowReducer;
     double _lastUpdateRate;
+    size_t _lastNumPoints;
     double _displayRate;
     double _sampleRate;
     double _sampleRateWoAxisUnits;
@@ -151,8 +262,37 @@ private:
     double _centerFreqWoAxisUnits;
     size_t _numBins;
     double _timeSpan;
+    size_t _timeLevels;
     double _refLevel;
     double _dynRange;
+    std::vector<double> _historyRange;
+    std::string _recordFile;
+    size_t _recordDepth;
+    std::shared_ptr<SpectrogramRecorder> _recorder; //accessed with std::atomic_load/store
+    bool _paused;
+    std::atomic<double> _scrollback; //!< set by both the GUI and block calls
+    double _frozenTime;
+    SpectrogramDetector _detector;
+    bool _detectorEnabled;
+    std::unique_ptr<SpectrogramDetectionsItem> _detectionsItem;
+    QFuture<void> _exportFuture;
+    bool _zoomAnalysis;
+    std::shared_ptr<FrequencyZoom> _freqZoom; //accessed with std::atomic_load/store
+    std::shared_ptr<FrequencyZoom> _workZoom; //only used by the work thread
+    std::vector<std::complex<float>> _zoomSamps;
+    bool _sweepEnabled;
+    bool _sweepReset; //!< clear the stitcher on the next frame
+    bool _sweepLayout; //!< the raster holds stitched rows
+    double _sweepTrim;
+    double _sweepMaxAge;
+    double _sweepLow, _sweepHigh; //!< the stitched band of the last row
+    size_t _sweepCols;
+    PothosSweepStitcher _sweep; //!< only used by the work thread
+    bool _streamingMode;
+    size_t _hopSize;
+    std::vector<std::complex<float>> _streamSamps;
+    size_t _streamSkip;
+    bool _powerOutput;
     double _fullScale;
     bool _fftModeComplex;
     bool _fftModeAutomatic;
@@ -0,0 +1,746 @@
+// Copyright (c) 2014-2016 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "SpectrogramRaster.hpp"
+#include <Pothos/Exception.hpp>
+#include <unordered_map>
+#include <map>
+#include <limits>
+#include <cmath>
+
+/***********************************************************************
+ * Row storage with optional quantization
+ **********************************************************************/
+template <typename T>
+static void quantizeBins(const std::valarray<float> &bins, const float offset, const float step, std::vector<T> &codes)
+{
+    const float scale = 1.0f/step;
+    const float maxCode = float(std::numeric_limits<T>::max());
+    codes.resize(bins.size());
+    for (size_t i = 0; i < bins.size(); i++)
+    {
+        const float code = (bins[i]-offset)*scale + 0.5f;
+        codes[i] = T(std::min(std::max(code, 0.0f), maxCode));
+    }
+}
+
+template <typename T>
+static void dequantizeBins(const std::vector<T> &codes, const float offset, const float step, std::valarray<float> &bins)
+{
+    bins.resize(codes.size());
+    for (size_t i = 0; i < codes.size(); i++)
+    {
+        bins[i] = offset + step*codes[i];
+    }
+}
+
+SpectrogramRow::SpectrogramRow(const std::valarray<float> &bins, const SpectrogramRowFormat &format, const bool half):
+    numBins(bins.size()),
+    half(half),
+    format(format),
+    offset(0.0f),
+    step(1.0f)
+{
+    if (format.bits == 32)
+    {
+        f32.assign(std::begin(bins), std::end(bins));
+        return;
+    }
+
+    const float maxCode = (format.bits == 16)?65535.0f:255.0f;
+    offset = format.lo;
+    step = std::max(format.hi-format.lo, 1e-3f)/maxCode;
+    if (format.bits == 16) quantizeBins(bins, offset, step, u16);
+    else quantizeBins(bins, offset, step, u8);
+}
+
+template <typename T>
+static void gatherCodes(const std::vector<T> &in, const std::vector<size_t> &index, std::vector<T> &out)
+{
+    if (in.empty()) return;
+    out.resize(index.size());
+    for (size_t i = 0; i < index.size(); i++) out[i] = in[index[i]];
+}
+
+SpectrogramRow::SpectrogramRow(const SpectrogramRow &row, const std::vector<size_t> &index):
+    numBins(index.size()),
+    half(row.half),
+    format(row.format),
+    offset(row.offset),
+    step(row.step)
+{
+    gatherCodes(row.f32, index, f32);
+    gatherCodes(row.u16, index, u16);
+    gatherCodes(row.u8, index, u8);
+}
+
+std::valarray<float> SpectrogramRow::bins(void) const
+{
+    std::valarray<float> out;
+    if (format.bits == 32) out = std::valarray<float>(f32.data(), f32.size());
+    else if (format.bits == 16) dequantizeBins(u16, offset, step, out);
+    else dequantizeBins(u8, offset, step, out);
+    return out;
+}
+
+/***********************************************************************
+ * Raster implementation
+ **********************************************************************/
+
+MySpectrogramRasterData::MySpectrogramRasterData(void):
+    _yOff(0.0f),
+    _yScale(0.0f),
+    _colOff(0.0),
+    _colScale(0.0),
+    _numPixelCols(1),
+    _levels(1),
+    _levelReducers(1),
+    _numRows(0),
+    _frozen(false),
+    _nextMapId(0),
+    _numCols(1),
+    _isComplex(true),
+    _rowInterval(0.0, 1.0),
+    _layoutPending(false),
+    _pendingComplex(true),
+    _pendingResample(false),
+    _meanColumns(false)
+{
+    _levelReducers.front().setNumPerRow(2);
+    this->setNumRows(1);
+
+    //initial render for value() lookups before the first render
+    _pooledSnapshot.push_back(poolRow(*_emptyRow, *this->makeColumnMap(_numCols, false, _isComplex, _meanColumns, _geometry)));
+    _pixelRows.push_back(_pooledSnapshot.front()->values.data());
+}
+
+MySpectrogramRasterData::RowPtr MySpectrogramRasterData::makeRow(const std::valarray<float> &bins, const bool half)
+{
+    std::shared_ptr<const SpectrogramColumnMap> map;
+    SpectrogramRowFormat format;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        map = _columnMap;
+        format = _format;
+    }
+
+    //reduce the new row to the pixel columns of the last render
+    std::shared_ptr<SpectrogramRow> row(new SpectrogramRow(bins, format, half));
+    if (map and map->numBins == bins.size() and map->half == half) row->pooled = poolRow(*row, *map);
+    return row;
+}
+
+//nearest bin of the old row at the frequency of each new bin
+static std::valarray<float> resampleBins(const std::valarray<float> &bins, const QwtInterval &oldInterval, const QwtInterval &newInterval, const size_t newSize)
+{
+    std::valarray<float> newBins(-1000.0f, newSize);
+    const double oldScale = (double(bins.size())-1)/std::max(oldInterval.width(), 1e-20);
+    const double newStep = newInterval.width()/std::max<size_t>(newSize-1, 1);
+    for (size_t i = 0; i < newSize; i++)
+    {
+        const double bin = std::floor((newInterval.minValue() + i*newStep - oldInterval.minValue())*oldScale + 0.5);
+        if (bin >= 0.0 and bin < double(bins.size())) newBins[i] = bins[size_t(bin)];
+    }
+    return newBins;
+}
+
+MySpectrogramRasterData::RowPtr MySpectrogramRasterData::createRow(const std::valarray<float> &bins, const QwtInterval &interval)
+{
+    size_t numCols = 0;
+    bool isComplex = true;
+    QwtInterval rowInterval;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        numCols = _numCols;
+        isComplex = _isComplex;
+        rowInterval = _rowInterval;
+    }
+
+    const bool half = not isComplex;
+    return this->makeRow(resampleBins(bins, interval, rowInterval, half?(numCols/2+1):numCols), half);
+}
+
+MySpectrogramRasterData::RowPtr MySpectrogramRasterData::createRow(const std::valarray<float> &bins)
+{
+    size_t numCols = 0;
+    bool isComplex = true;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        numCols = _numCols;
+        isComplex = _isComplex;
+    }
+
+    //rows from a real FFT only contain the bins from DC to fs/2
+    const bool half = (numCols > 2 and bins.size() == numCols/2+1);
+
+    //fold the redundant half of a full spectrum in real mode,
+    //the center bin is DC and the first bin is -fs/2 == +fs/2
+    if (not half and not isComplex and bins.size() == numCols and numCols > 2)
+    {
+        std::valarray<float> halfBins(numCols/2+1);
+        halfBins[std::slice(0, numCols/2, 1)] = bins[std::slice(numCols/2, numCols/2, 1)];
+        halfBins[numCols/2] = bins[0];
+        return this->makeRow(halfBins, true);
+    }
+    return this->makeRow(bins, half);
+}
+
+void MySpectrogramRasterData::appendBins(const std::valarray<float> &bins)
+{
+    //apply a queued layout change before appending a row in the new layout
+    bool layoutPending = false;
+    QwtInterval interval;
+    bool isComplex = true, resample = false;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        std::swap(layoutPending, _layoutPending);
+        interval = _pendingInterval;
+        isComplex = _pendingComplex;
+        resample = _pendingResample;
+    }
+    if (layoutPending) this->setRowInterval(interval, isComplex, resample);
+
+    auto row = this->createRow(bins);
+
+    //push into each level, decimating the rows that overflow into the next
+    for (size_t level = 0; row; level++)
+    {
+        //overflow rows are released outside of the lock
+        RowPtr overflow;
+        {
+            std::unique_lock<std::mutex> lock(_rasterMutex);
+            if (level >= _levels.size()) break;
+            auto &rows = _levels[level];
+            rows.push_front(row);
+            if (rows.size() > _numRows)
+            {
+                overflow = rows.back();
+                rows.pop_back();
+            }
+            if (level+1 == _levels.size()) break;
+        }
+        row.reset();
+        if (not overflow) continue;
+
+        //the level reducers are resized and reconfigured by the setters
+        std::unique_lock<std::mutex> rewriteLock(_rewriteMutex);
+        if (level < _levelReducers.size() and _levelReducers[level].feed(overflow->bins()))
+        {
+            row = this->makeRow(_levelReducers[level].row(), overflow->half);
+        }
+    }
+}
+
+void MySpectrogramRasterData::initRaster(const QRectF &area, const QSize &raster)
+{
+    //snapshot the row pointers, the rows themselves are never modified
+    size_t numCols = 0;
+    bool isComplex = true;
+    bool meanColumns = false;
+    std::shared_ptr<const SpectrogramColumnMap> map;
+    RowPtr emptyRow;
+    QwtInterval rowInterval;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        this->setNumRows(raster.height());
+        _snapshot = this->snapshotLocked();
+        emptyRow = _emptyRow;
+        numCols = _numCols;
+        isComplex = _isComplex;
+        meanColumns = _meanColumns;
+        map = _columnMap;
+        rowInterval = _rowInterval;
+    }
+
+    //rows in the current FFT mode span the entire row interval
+    SpectrogramColumnGeometry geometry;
+    geometry.numPixelCols = size_t(std::max(raster.width(), 1));
+    geometry.areaLeft = area.left();
+    geometry.areaWidth = area.width();
+    geometry.xMin = rowInterval.minValue();
+    geometry.xWidth = rowInterval.width();
+    const bool half = not isComplex;
+    const size_t numBins = half?(numCols/2+1):numCols;
+
+    //pixel column as a function of the x coordinate
+    _numPixelCols = geometry.numPixelCols;
+    _colOff = area.left();
+    _colScale = _numPixelCols/area.width();
+
+    //pixel row as a function of the y coordinate
+    const size_t numPixelRows = size_t(std::max(raster.height(), 1));
+    _yOff = area.top();
+    _yScale = numPixelRows/area.height();
+
+    //create a new column map when the geometry changes
+    if (not map or map->numBins != numBins or map->half != half or
+        map->isComplex != isComplex or map->mean != meanColumns or
+        not (geometry == _geometry))
+    {
+        _geometry = geometry;
+        map = this->makeColumnMap(numBins, half, isComplex, meanColumns, geometry);
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        _columnMap = map;
+    }
+
+    //select the finest available row for each pixel row
+    _pooledSnapshot.resize(numPixelRows);
+    _pixelRows.resize(numPixelRows);
+    std::map<std::pair<size_t, bool>, std::shared_ptr<const SpectrogramColumnMap>> otherMaps;
+    for (size_t p = 0; p < numPixelRows; p++)
+    {
+        const double y = _yOff + (p+0.5)/_yScale;
+        const auto &row = *this->selectRow(_snapshot, *emptyRow, this->interval(Qt::YAxis), y);
+
+        //recompute pooled rows that were reduced for a different geometry
+        auto pooled = std::atomic_load(&row.pooled);
+        if (not pooled or pooled->mapId != map->id)
+        {
+            //rows of a different size or layout are mapped with a temporary map
+            const bool match = row.size() == map->numBins and row.half == map->half;
+            auto &otherMap = otherMaps[std::make_pair(row.size(), row.half)];
+            if (not match and not otherMap)
+            {
+                otherMap = this->makeColumnMap(row.size(), row.half, isComplex, meanColumns, geometry);
+            }
+            pooled = poolRow(row, match?*map:*otherMap);
+            if (match) std::atomic_store(&row.pooled, pooled);
+        }
+        _pooledSnapshot[p] = pooled;
+        _pixelRows[p] = pooled->values.data();
+    }
+}
+
+std::vector<std::vector<MySpectrogramRasterData::RowPtr>> MySpectrogramRasterData::snapshotLocked(void) const
+{
+    if (_frozen) return _frozenLevels;
+    std::vector<std::vector<RowPtr>> levels(_levels.size());
+    for (size_t level = 0; level < _levels.size(); level++)
+    {
+        levels[level].assign(_levels[level].begin(), _levels[level].end());
+    }
+    return levels;
+}
+
+const SpectrogramRow *MySpectrogramRasterData::selectRow(const std::vector<std::vector<RowPtr>> &levels, const SpectrogramRow &emptyRow, const QwtInterval &yInterval, const double y)
+{
+    //the newest level has one row per pixel over a fraction of the time axis,
+    //level k begins at base row C*(2^k - 1) and each of its rows spans 2^k base rows,
+    //so the time axis spans the C*(2^L - 1) base rows of all L levels
+    const size_t C = std::max<size_t>(levels.front().size(), 1);
+    const size_t numBase = C*((size_t(1) << levels.size())-1);
+    const double baseScale = double(numBase-1)/yInterval.width();
+    const size_t base = size_t(std::max(std::floor(baseScale*(y-yInterval.minValue())+0.5), 0.0));
+    for (size_t level = 0; level < levels.size(); level++)
+    {
+        const size_t begin = C*((size_t(1) << level)-1);
+        const size_t end = C*((size_t(1) << (level+1))-1);
+        if (base >= end and level+1 < levels.size()) continue;
+        const size_t index = std::min((base-std::min(base, begin)) >> level, C-1);
+        if (index < levels[level].size()) return levels[level][index].get();
+        break;
+    }
+    return &emptyRow;
+}
+
+QImage MySpectrogramRasterData::renderImage(const QRectF &area, const QSize &size, const std::vector<uint32_t> &colorTable, const QwtInterval &range)
+{
+    std::vector<std::vector<RowPtr>> levels;
+    RowPtr emptyRow;
+    bool isComplex = true;
+    bool meanColumns = false;
+    QwtInterval rowInterval;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        levels = this->snapshotLocked();
+        emptyRow = _emptyRow;
+        isComplex = _isComplex;
+        meanColumns = _meanColumns;
+        rowInterval = _rowInterval;
+    }
+
+    SpectrogramColumnGeometry geometry;
+    geometry.numPixelCols = size_t(std::max(size.width(), 1));
+    geometry.areaLeft = area.left();
+    geometry.areaWidth = area.width();
+    geometry.xMin = rowInterval.minValue();
+    geometry.xWidth = rowInterval.width();
+    const auto yInterval = this->interval(Qt::YAxis);
+
+    //pool each row onto the image columns and colorize with the lookup table
+    QImage image(size, QImage::Format_RGB32);
+    const float lutScale = float(colorTable.size()-1)/float(std::max(range.width(), 1e-9));
+    const float lutMax = float(colorTable.size()-1);
+    std::map<std::pair<size_t, bool>, std::shared_ptr<const SpectrogramColumnMap>> maps;
+    for (int p = 0; p < image.height(); p++)
+    {
+        const double y = area.bottom() - (p+0.5)*area.height()/image.height();
+        const auto &row = *this->selectRow(levels, *emptyRow, yInterval, y);
+        auto &map = maps[std::make_pair(row.size(), row.half)];
+        if (not map) map = this->makeColumnMap(row.size(), row.half, isComplex, meanColumns, geometry);
+        const auto pooled = poolRow(row, *map);
+        auto out = reinterpret_cast<uint32_t *>(image.scanLine(p));
+        for (size_t c = 0; c < pooled->values.size(); c++)
+        {
+            const float index = (pooled->values[c]-float(range.minValue()))*lutScale;
+            out[c] = colorTable[size_t(std::min(std::max(index, 0.0f), lutMax))];
+        }
+    }
+    return image;
+}
+
+std::vector<float> MySpectrogramRasterData::renderRows(const QRectF &area, const size_t numRows, size_t &numCols)
+{
+    std::vector<std::vector<RowPtr>> levels;
+    RowPtr emptyRow;
+    bool isComplex = true;
+    QwtInterval xInterval;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        levels = this->snapshotLocked();
+        emptyRow = _emptyRow;
+        numCols = _numCols;
+        isComplex = _isComplex;
+        xInterval = _rowInterval;
+    }
+
+    //the bins of the current layout that fall within the area
+    const auto yInterval = this->interval(Qt::YAxis);
+    const size_t numBins = std::max<size_t>(isComplex?numCols:(numCols/2+1), 2);
+    const double binScale = (numBins-1)/xInterval.width();
+    const auto clampBin = [&](const double bin){return size_t(std::min(std::max(bin, 0.0), double(numBins-1)));};
+    const size_t lo = clampBin(std::ceil(binScale*(area.left()-xInterval.minValue())));
+    const size_t hi = clampBin(std::floor(binScale*(area.right()-xInterval.minValue())))+1;
+    numCols = (hi > lo)?(hi-lo):0;
+
+    //decode each row, rows of a different size are resampled to the nearest bin
+    std::vector<float> out(numRows*numCols);
+    for (size_t p = 0; p < numRows; p++)
+    {
+        const double y = area.bottom() - (p+0.5)*area.height()/numRows;
+        const auto &row = *this->selectRow(levels, *emptyRow, yInterval, y);
+        const auto bins = row.bins();
+        for (size_t c = 0; c < numCols; c++)
+        {
+            const size_t bin = ((lo+c)*(bins.size()-1) + (numBins-1)/2)/(numBins-1);
+            out[p*numCols+c] = bins[std::min(bin, bins.size()-1)];
+        }
+    }
+    return out;
+}
+
+void MySpectrogramRasterData::discardRaster(void)
+{
+    //the pixel rows are kept for value() lookups from the plot picker
+    //but the snapshot of the history is released until the next render
+    _snapshot.clear();
+}
+
+void MySpectrogramRasterData::setNumColumns(const size_t numCols)
+{
+    std::unique_lock<std::mutex> rewriteLock(_rewriteMutex);
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        if (numCols == _numCols) return;
+        _numCols = numCols;
+        _emptyRow.reset(new SpectrogramRow(std::valarray<float>(-1000, _numCols), SpectrogramRowFormat()));
+    }
+
+    //nearest bin index map for each (old size, new size) pair, computed once
+    std::map<std::pair<size_t, size_t>, std::vector<size_t>> indexMaps;
+    this->rewriteRows([numCols, &indexMaps](const SpectrogramRow &row)
+    {
+        const size_t oldSize = row.size();
+        const size_t newSize = row.half?(numCols/2+1):numCols;
+        if (oldSize == newSize or oldSize == 0) return RowPtr();
+        auto &index = indexMaps[std::make_pair(oldSize, newSize)];
+        if (index.empty())
+        {
+            index.resize(newSize);
+            const size_t den = std::max<size_t>(newSize-1, 1);
+            for (size_t i = 0; i < newSize; i++) index[i] = (i*(oldSize-1) + den/2)/den;
+        }
+        return RowPtr(new SpectrogramRow(row, index));
+    });
+}
+
+void MySpectrogramRasterData::setFrozen(const bool frozen)
+{
+    std::unique_lock<std::mutex> lock(_rasterMutex);
+    if (frozen == _frozen) return;
+    _frozen = frozen;
+    _frozenLevels.clear();
+
+    //capture the history as it was displayed when frozen
+    if (not _frozen) return;
+    for (const auto &level : _levels)
+    {
+        _frozenLevels.emplace_back(level.begin(), level.end());
+    }
+}
+
+void MySpectrogramRasterData::setFrozenRows(const std::vector<RowPtr> &rows)
+{
+    std::unique_lock<std::mutex> lock(_rasterMutex);
+    _frozen = true;
+    _frozenLevels.assign(1, rows);
+    if (rows.empty()) _frozenLevels.front().push_back(_emptyRow);
+}
+
+void MySpectrogramRasterData::setFFTMode(const bool isComplex)
+{
+    std::unique_lock<std::mutex> lock(_rasterMutex);
+    _isComplex = isComplex;
+}
+
+void MySpectrogramRasterData::setRowInterval(const QwtInterval &interval, const bool isComplex, const bool resample)
+{
+    std::unique_lock<std::mutex> rewriteLock(_rewriteMutex);
+    QwtInterval oldInterval;
+    size_t numCols = 0;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        oldInterval = _rowInterval;
+        _layoutPending = false; //superseded by this change
+        const bool changed = not (interval == oldInterval) or isComplex != _isComplex;
+        _isComplex = isComplex;
+        _rowInterval = interval;
+        numCols = _numCols;
+        if (not changed or not resample) return;
+    }
+
+    const bool half = not isComplex;
+    const size_t newSize = half?(numCols/2+1):numCols;
+    this->rewriteRows([=](const SpectrogramRow &row)
+    {
+        return RowPtr(new SpectrogramRow(resampleBins(row.bins(), oldInterval, interval, newSize), row.format, half));
+    });
+}
+
+void MySpectrogramRasterData::postRowInterval(const QwtInterval &interval, const bool isComplex, const bool resample)
+{
+    std::unique_lock<std::mutex> lock(_rasterMutex);
+    _pendingResample = (_layoutPending and _pendingResample) or resample;
+    _pendingInterval = interval;
+    _pendingComplex = isComplex;
+    _layoutPending = true;
+}
+
+void MySpectrogramRasterData::setColumnReduce(const std::string &mode)
+{
+    if (mode == "MAX"){}
+    else if (mode == "MEAN"){}
+    else throw Pothos::InvalidArgumentException("MySpectrogramRasterData::setColumnReduce("+mode+")", "unknown mode");
+    std::unique_lock<std::mutex> lock(_rasterMutex);
+    _meanColumns = (mode == "MEAN");
+}
+
+void MySpectrogramRasterData::setNumLevels(const size_t numLevels)
+{
+    if (numLevels < 1 or numLevels > 16) throw Pothos::RangeException(
+        "MySpectrogramRasterData::setNumLevels("+std::to_string(numLevels)+")",
+        "levels must be in [1, 16]");
+    std::unique_lock<std::mutex> rewriteLock(_rewriteMutex);
+    std::unique_lock<std::mutex> lock(_rasterMutex);
+    _levels.resize(numLevels);
+    _levelReducers.resize(numLevels, _levelReducers.front());
+    for (auto &reducer : _levelReducers) reducer.setNumPerRow(2);
+}
+
+void MySpectrogramRasterData::setTimeReduce(const std::string &mode)
+{
+    std::unique_lock<std::mutex> rewriteLock(_rewriteMutex);
+    for (auto &reducer : _levelReducers) reducer.setMode(mode);
+}
+
+void MySpectrogramRasterData::setStorageFormat(const std::string &format)
+{
+    auto newFormat = _format;
+    if (format == "FLOAT32") newFormat.bits = 32;
+    else if (format == "UINT16") newFormat.bits = 16;
+    else if (format == "UINT8") newFormat.bits = 8;
+    else throw Pothos::InvalidArgumentException("MySpectrogramRasterData::setStorageFormat("+format+")", "unknown format");
+    this->setRowFormat(newFormat);
+}
+
+void MySpectrogramRasterData::setStorageRange(const double lo, const double hi)
+{
+    if (lo >= hi) throw Pothos::RangeException("MySpectrogramRasterData::setStorageRange()", "range must be increasing");
+    auto newFormat = _format;
+    newFormat.lo = float(lo);
+    newFormat.hi = float(hi);
+    this->setRowFormat(newFormat);
+}
+
+void MySpectrogramRasterData::setRowFormat(const SpectrogramRowFormat &format)
+{
+    std::unique_lock<std::mutex> rewriteLock(_rewriteMutex);
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        const bool changed = not (format == _format);
+        _format = format;
+        if (not changed) return;
+    }
+
+    //requantize the existing history to the new format
+    this->rewriteRows([format](const SpectrogramRow &row)
+    {
+        return RowPtr(new SpectrogramRow(row.bins(), format, row.half));
+    });
+}
+
+void MySpectrogramRasterData::rewriteRows(const std::function<RowPtr(const SpectrogramRow &)> &convert)
+{
+    //snapshot the row pointers under the lock
+    std::vector<RowPtr> rows;
+    {
+        std::unique_lock<std::mutex> lock(_rasterMutex);
+        for (const auto &level : _levels) rows.insert(rows.end(), level.begin(), level.end());
+    }
+
+    //convert each unique row outside of the lock
+    std::unordered_map<const SpectrogramRow *, RowPtr> converted;
+    for (const auto &row : rows)
+    {
+        if (converted.count(row.get()) != 0) continue;
+        auto newRow = convert(*row);
+        if (newRow) converted[row.get()] = newRow;
+    }
+
+    //swap the converted rows into the history,
+    //rows appended in the meantime are not in the map
+    std::unique_lock<std::mutex> lock(_rasterMutex);
+    for (auto &level : _levels)
+    {
+        for (auto &row : level)
+        {
+            const auto it = converted.find(row.get());
+            if (it != converted.end()) row = it->second;
+        }
+    }
+}
+
+void MySpectrogramRasterData::setNumRows(const int num)
+{
+    if (not _emptyRow) _emptyRow.reset(new SpectrogramRow(std::valarray<float>(-1000, _numCols), SpectrogramRowFormat()));
+    _numRows = size_t(std::max(num, 1));
+    for (auto &rows : _levels)
+    {
+        while (rows.size() > _numRows) rows.pop_back();
+    }
+
+    //the newest level is padded so the display scrolls from the bottom
+    auto &rows = _levels.front();
+    if (rows.empty()) rows.push_front(_emptyRow);
+    while (rows.size() < _numRows) rows.push_front(rows.front());
+}
+
+std::shared_ptr<const SpectrogramColumnMap> MySpectrogramRasterData::makeColumnMap(const size_t numBins, const bool half, const bool isComplex, const bool mean, const SpectrogramColumnGeometry &geometry)
+{
+    std::shared_ptr<SpectrogramColumnMap> map(new SpectrogramColumnMap());
+    map->id = _nextMapId++;
+    map->numBins = std::max<size_t>(numBins, 1);
+    map->half = half;
+    map->isComplex = isComplex;
+    map->mean = mean;
+    map->lo.resize(geometry.numPixelCols);
+    map->hi.resize(geometry.numPixelCols);
+
+    //fractional bin index as a function of the x coordinate:
+    //half spectrum rows and complex mode rows span the x interval,
+    //full spectrum rows in real mode display the positive frequencies
+    double binOff = geometry.xMin, binScale = (map->numBins-1)/geometry.xWidth;
+    if (not half and not isComplex)
+    {
+        binScale = (map->numBins/2-1)/geometry.xWidth;
+        binOff = geometry.xMin - geometry.xWidth;
+    }
+    const double dx = geometry.areaWidth/geometry.numPixelCols;
+    const auto binAt = [&](const double x){return std::floor(binScale*(x-binOff));};
+    const auto clampBin = [&](const double bin){return size_t(std::min(std::max(bin, 0.0), double(map->numBins-1)));};
+
+    for (size_t c = 0; c < geometry.numPixelCols; c++)
+    {
+        const double x0 = geometry.areaLeft + c*dx;
+        const double b0 = binAt(x0), b1 = binAt(x0+dx);
+
+        //fewer bins than pixels: sample the bin under the column center
+        if (b1 - b0 <= 1.0)
+        {
+            map->lo[c] = clampBin(binAt(x0+dx/2));
+            map->hi[c] = map->lo[c]+1;
+        }
+
+        //otherwise reduce every bin that falls within the column
+        else
+        {
+            map->lo[c] = clampBin(b0);
+            map->hi[c] = std::max(clampBin(b1-1.0)+1, map->lo[c]+1);
+        }
+    }
+    return map;
+}
+
+/***********************************************************************
+ * Column reduction kernels: independent accumulators
+ * let the compiler vectorize and pipeline the inner loops.
+ * The kernels operate directly on the stored codes,
+ * which are an increasing linear function of the power in dB.
+ **********************************************************************/
+template <typename T>
+static inline T reduceMax(const T *p, const size_t n)
+{
+    T m0 = p[0], m1 = p[0], m2 = p[0], m3 = p[0];
+    size_t i = 0;
+    for (; i+4 <= n; i += 4)
+    {
+        m0 = std::max(m0, p[i+0]);
+        m1 = std::max(m1, p[i+1]);
+        m2 = std::max(m2, p[i+2]);
+        m3 = std::max(m3, p[i+3]);
+    }
+    for (; i < n; i++) m0 = std::max(m0, p[i]);
+    return std::max(std::max(m0, m1), std::max(m2, m3));
+}
+
+template <typename T>
+static inline float reduceMean(const T *p, const size_t n)
+{
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i+4 <= n; i += 4)
+    {
+        s0 += p[i+0];
+        s1 += p[i+1];
+        s2 += p[i+2];
+        s3 += p[i+3];
+    }
+    for (; i < n; i++) s0 += p[i];
+    return ((s0 + s1) + (s2 + s3))/n;
+}
+
+template <typename T>
+static void poolCodes(const T *codes, const SpectrogramColumnMap &map, const float offset, const float step, float *out)
+{
+    for (size_t c = 0; c < map.lo.size(); c++)
+    {
+        const auto lo = map.lo[c], n = map.hi[c]-map.lo[c];
+        float code = 0.0f;
+        if (n == 1) code = float(codes[lo]);
+        else if (map.mean) code = reduceMean(codes+lo, n);
+        else code = float(reduceMax(codes+lo, n));
+        out[c] = offset + step*code;
+    }
+}
+
+std::shared_ptr<const SpectrogramPooledRow> MySpectrogramRasterData::poolRow(const SpectrogramRow &row, const SpectrogramColumnMap &map)
+{
+    std::shared_ptr<SpectrogramPooledRow> pooled(new SpectrogramPooledRow());
+    pooled->mapId = map.id;
+    pooled->values.resize(map.lo.size());
+    auto out = pooled->values.data();
+    if (row.format.bits == 32) poolCodes(row.f32.data(), map, row.offset, row.step, out);
+    else if (row.format.bits == 16) poolCodes(row.u16.data(), map, row.offset, row.step, out);
+    else poolCodes(row.u8.data(), map, row.offset, row.step, out);
+    return pooled;
+}
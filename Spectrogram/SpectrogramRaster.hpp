@@ -4,103 +4,302 @@
 #pragma once
 #include <Pothos/Config.hpp>
 #include <qwt_raster_data.h>
-#include <QList>
+#include <QImage>
+#include "SpectrogramRowReducer.hpp"
 #include <valarray>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
 #include <mutex>
+#include <functional>
+#include <cstdint>
+#include <atomic>
+#include <algorithm> //min
 
-class MySpectrogramRasterData : public QwtRasterData
+//! Mapping of full resolution bins onto the pixel columns of a render
+struct SpectrogramColumnMap
 {
-public:
-    MySpectrogramRasterData(void):
-        _numCols(1),
-        _isComplex(true)
+    size_t id; //!< unique identifier for this geometry
+    size_t numBins; //!< row size that this map applies to
+    bool half; //!< map applies to half spectrum rows
+    bool isComplex; //!< the FFT mode of the render
+    bool mean; //!< reduce with mean or max
+    std::vector<size_t> lo, hi; //!< bin range for each pixel column
+};
+
+//! Geometry of the pixel columns for a render
+struct SpectrogramColumnGeometry
+{
+    SpectrogramColumnGeometry(void):
+        numPixelCols(1), areaLeft(0.0), areaWidth(1.0), xMin(0.0), xWidth(1.0){}
+
+    size_t numPixelCols;
+    double areaLeft, areaWidth; //!< x interval of the rendered area
+    double xMin, xWidth; //!< x interval spanned by the rows
+
+    bool operator==(const SpectrogramColumnGeometry &other) const
     {
-        this->setNumRows(1);
+        return numPixelCols == other.numPixelCols and
+            areaLeft == other.areaLeft and areaWidth == other.areaWidth and
+            xMin == other.xMin and xWidth == other.xWidth;
     }
+};
 
-    //! translate a plot coordinate into a raster value
-    double value(double x, double y) const
+//! A row reduced to pixel columns for a particular column map
+struct SpectrogramPooledRow
+{
+    size_t mapId;
+    std::vector<float> values;
+};
+
+//! Storage format for rows in the spectrogram history
+struct SpectrogramRowFormat
+{
+    SpectrogramRowFormat(void):
+        bits(32), lo(-150.0f), hi(0.0f){}
+
+    int bits; //!< 32 for float, 16 or 8 for quantized dB codes
+    float lo, hi; //!< dB range covered by the quantized codes
+
+    bool operator==(const SpectrogramRowFormat &other) const
     {
-        const auto time = size_t(_yScale*(y-_yOff));
-        const auto bin = size_t(_xScale*(x-_xOff));
-        return _data[time][bin];
+        return bits == other.bits and (bits == 32 or (lo == other.lo and hi == other.hi));
     }
+};
 
-    //! append a new power spectrum bin array
-    void appendBins(const std::valarray<float> &bins)
+//! A single power spectrum in the spectrogram history
+struct SpectrogramRow
+{
+    //! encode power bins (in dB) with the given storage format
+    SpectrogramRow(const std::valarray<float> &bins, const SpectrogramRowFormat &format, const bool half = false);
+
+    //! resample another row with a bin index map, the stored codes are copied as-is
+    SpectrogramRow(const SpectrogramRow &row, const std::vector<size_t> &index);
+
+    //! the number of power bins in this row
+    size_t size(void) const
     {
-        std::unique_lock<std::mutex> lock(_rasterMutex);
-        _data.push_front(bins);
-        _data.pop_back();
+        return numBins;
     }
 
-    //! A raster operation has begun
-    void initRaster(const QRectF &, const QSize &raster)
-    {
-        _rasterMutex.lock();
-
-        this->setNumRows(raster.height());
-
-        _yOff = this->interval(Qt::YAxis).minValue();
-        _yScale = (_data.size()-1)/this->interval(Qt::YAxis).width();
-        if (_isComplex)
-        {
-            _xOff = this->interval(Qt::XAxis).minValue();
-            _xScale = (_numCols-1)/this->interval(Qt::XAxis).width();
-        }
-        else
-        {
-            _xScale = (_numCols/2-1)/this->interval(Qt::XAxis).width();
-            _xOff = this->interval(Qt::XAxis).minValue() - this->interval(Qt::XAxis).width();
-        }
+    //! decode the row back into power bins (in dB)
+    std::valarray<float> bins(void) const;
 
-    }
+    //! full resolution data, never modified after creation,
+    //! only the vector for the storage format is non-empty
+    size_t numBins;
+    bool half; //!< only the bins from DC to fs/2 (N/2+1 bins)
+    SpectrogramRowFormat format;
+    std::vector<float> f32;
+    std::vector<uint16_t> u16;
+    std::vector<uint8_t> u8;
 
-    //! A raster operation has ended
-    void discardRaster(void)
+    //! decoded dB = offset + step*code
+    float offset, step;
+
+    //! pixel column cache, accessed with std::atomic_load/store
+    mutable std::shared_ptr<const SpectrogramPooledRow> pooled;
+};
+
+/*!
+ * Raster data for the spectrogram plot.
+ *
+ * Rows are immutable once appended and shared by pointer,
+ * so a render takes a snapshot of the row list under a brief lock
+ * and reads from the snapshot without blocking appendBins().
+ *
+ * Each row keeps its full resolution bins and a cached reduction
+ * onto the pixel columns of the current render. The reduction is
+ * applied on append and recomputed when the zoom or size changes.
+ *
+ * The history is a pyramid of levels with one row per pixel each.
+ * Rows that age out of a level are decimated by two into the next,
+ * and the levels are stacked along the time axis, each level spanning
+ * twice the time of the previous one, so the newer levels keep every
+ * row at a finer time resolution and every stored row is displayed.
+ *
+ * Rows may be stored as 8 or 16-bit dB codes to reduce memory.
+ * The pixel column reductions operate directly on the codes.
+ *
+ * In real FFT mode only the unique half of the spectrum is stored.
+ *
+ * The display can be frozen while rows continue to be appended,
+ * and the frozen rows can be replaced with rows from a recording.
+ */
+class MySpectrogramRasterData : public QwtRasterData
+{
+public:
+    typedef std::shared_ptr<const SpectrogramRow> RowPtr;
+
+    MySpectrogramRasterData(void);
+
+    //! translate a plot coordinate into a raster value
+    double value(double x, double y) const
     {
-        _rasterMutex.unlock();
+        const auto time = clampIndex(_yScale*(y-_yOff), _pixelRows.size());
+        const auto col = clampIndex(_colScale*(x-_colOff), _numPixelCols);
+        return _pixelRows[time][col];
     }
 
+    /*!
+     * Append a new power spectrum bin array.
+     * Rows with N/2+1 bins are stored as a half spectrum from DC to fs/2.
+     * Rows with N bins are folded into a half spectrum in real FFT mode.
+     */
+    void appendBins(const std::valarray<float> &bins);
+
+    //! Create a history row from power bins, see appendBins() for the layout
+    RowPtr createRow(const std::valarray<float> &bins);
+
+    /*!
+     * Create a history row from power bins that span an x interval,
+     * like a row from a recording that was captured with a different band.
+     * The bins are resampled onto the current row interval and layout,
+     * bins outside of the interval are empty.
+     */
+    RowPtr createRow(const std::valarray<float> &bins, const QwtInterval &interval);
+
+    //! Freeze the displayed rows, appended rows are still kept in the history
+    void setFrozen(const bool frozen);
+
+    //! Freeze the display with these rows (newest first, evenly spaced in time)
+    void setFrozenRows(const std::vector<RowPtr> &rows);
+
+    //! A raster operation has begun
+    void initRaster(const QRectF &area, const QSize &raster);
+
+    //! A raster operation has ended
+    void discardRaster(void);
+
     //! Change the number of bins per power spectrum
-    void setNumColumns(const size_t numCols)
-    {
-        std::unique_lock<std::mutex> lock(_rasterMutex);
-        if (numCols == _numCols) return;
-        _numCols = numCols;
-        for (auto &row : _data)
-        {
-            std::valarray<float> newRow(_numCols);
-            for (size_t i = 0; i < newRow.size(); i++)
-                newRow[i] = row[size_t((double(i)*(row.size()-1))/(newRow.size()-1))];
-            row = newRow;
-        }
-    }
+    void setNumColumns(const size_t numCols);
 
     //! Set the rendering mode for real valued signals
-    void setFFTMode(const bool isComplex)
-    {
-        std::unique_lock<std::mutex> lock(_rasterMutex);
-        _isComplex = isComplex;
-    }
+    void setFFTMode(const bool isComplex);
+
+    /*!
+     * Change the x interval spanned by the rows along with the FFT mode.
+     * The row interval is kept separately from the x interval of the raster
+     * so that it can be changed from the thread that appends the rows.
+     * When resample is set, the history is resampled onto the new interval so that
+     * old rows stay at the same frequencies, bins outside of the old interval are empty.
+     * The resample runs on the calling thread, see postRowInterval() for the GUI thread.
+     */
+    void setRowInterval(const QwtInterval &interval, const bool isComplex, const bool resample = true);
+
+    /*!
+     * Queue a row interval change to be applied by the next appendBins().
+     * The history is resampled on the thread that appends the rows,
+     * so a change from the GUI thread never waits on the resample.
+     * Changes queued before the next append are merged into one.
+     */
+    void postRowInterval(const QwtInterval &interval, const bool isComplex, const bool resample = true);
+
+    //! Set the pixel column reduction: MAX or MEAN
+    void setColumnReduce(const std::string &mode);
+
+    //! Set the number of levels in the time pyramid
+    void setNumLevels(const size_t numLevels);
+
+    //! Set the time decimation between levels: MAX, MEAN, or PEAK
+    void setTimeReduce(const std::string &mode);
+
+    //! Set the row storage format: FLOAT32, UINT16, or UINT8
+    void setStorageFormat(const std::string &format);
+
+    //! Set the dB range covered by the quantized storage formats
+    void setStorageRange(const double lo, const double hi);
+
+    /*!
+     * Render the displayed history offscreen with a color lookup table.
+     * The area is in plot coordinates, the top row of the image is the top of the area.
+     * This does not disturb the live render and is safe to call from any thread.
+     */
+    QImage renderImage(const QRectF &area, const QSize &size, const std::vector<uint32_t> &colorTable, const QwtInterval &range);
+
+    /*!
+     * Decode the displayed history over an area at full bin resolution,
+     * one row of the output per row of the area from top to bottom.
+     * \param [out] numCols the number of bins in each output row
+     */
+    std::vector<float> renderRows(const QRectF &area, const size_t numRows, size_t &numCols);
 
 private:
-    void setNumRows(const int num)
+    static size_t clampIndex(const double index, const size_t size)
     {
-        if (_data.isEmpty()) _data.push_front(std::valarray<float>(-1000, _numCols));
-        while (_data.size() > num) _data.pop_back();
-        while (_data.size() < num) _data.push_front(_data.front());
+        if (index <= 0.0) return 0;
+        return std::min(size_t(index), size-1);
     }
 
+    void setNumRows(const int num);
+
+    //! copy the displayed history, call with the raster mutex held
+    std::vector<std::vector<RowPtr>> snapshotLocked(void) const;
+
+    //! select the finest row in the pyramid for a y coordinate
+    static const SpectrogramRow *selectRow(const std::vector<std::vector<RowPtr>> &levels, const SpectrogramRow &emptyRow, const QwtInterval &yInterval, const double y);
+
+    RowPtr makeRow(const std::valarray<float> &bins, const bool half);
+
+    void setRowFormat(const SpectrogramRowFormat &format);
+
+    /*!
+     * Replace every row in the history with the result of a conversion.
+     * The conversion runs on a snapshot outside of the lock,
+     * and the converted rows are swapped in under a brief lock.
+     * Rows appended during the conversion, or converted to null, are kept as-is.
+     * Call with the rewrite mutex held so that conversions do not overlap.
+     */
+    void rewriteRows(const std::function<RowPtr(const SpectrogramRow &)> &convert);
+
+    std::shared_ptr<const SpectrogramColumnMap> makeColumnMap(const size_t numBins, const bool half, const bool isComplex, const bool mean, const SpectrogramColumnGeometry &geometry);
+
+    static std::shared_ptr<const SpectrogramPooledRow> poolRow(const SpectrogramRow &row, const SpectrogramColumnMap &map);
+
     //raster scale+adjustment factors
-    float _yOff, _yScale, _xOff, _xScale;
+    float _yOff, _yScale;
+
+    //geometry of the current render
+    double _colOff, _colScale;
+    size_t _numPixelCols;
+    SpectrogramColumnGeometry _geometry;
+
+    //raw data for each level of the pyramid (newest row first)
+    std::vector<std::deque<RowPtr>> _levels;
+    std::vector<SpectrogramRowReducer> _levelReducers;
+    size_t _numRows;
+    RowPtr _emptyRow;
 
-    //raw data for the entire raster
-    QList<std::valarray<float>> _data;
+    //rows displayed instead of the history while frozen
+    bool _frozen;
+    std::vector<std::vector<RowPtr>> _frozenLevels;
 
-    //thread-safe access mutex
+    //rows used by the current render, only accessed from the render thread
+    std::vector<std::vector<RowPtr>> _snapshot;
+    std::vector<std::shared_ptr<const SpectrogramPooledRow>> _pooledSnapshot;
+    std::vector<const float *> _pixelRows;
+
+    //column map for the current render, used by appendBins()
+    std::shared_ptr<const SpectrogramColumnMap> _columnMap;
+    std::atomic<size_t> _nextMapId;
+
+    //protects the row list and settings, never held during a render
     std::mutex _rasterMutex;
 
+    //serializes layout changes, held for the entire rewrite of the history,
+    //and guards the level reducers that are fed by appendBins()
+    std::mutex _rewriteMutex;
+
     size_t _numCols;
     bool _isComplex;
+    QwtInterval _rowInterval; //!< x interval spanned by the rows
+
+    //row interval change queued by postRowInterval()
+    bool _layoutPending;
+    QwtInterval _pendingInterval;
+    bool _pendingComplex;
+    bool _pendingResample;
+    bool _meanColumns;
+    SpectrogramRowFormat _format;
 };
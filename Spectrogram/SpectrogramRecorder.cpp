@@ -0,0 +1,157 @@
+// Copyright (c) 2014-2016 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "SpectrogramRecorder.hpp"
+#include <Pothos/Exception.hpp>
+#include <cstring>
+#include <algorithm> //min
+
+/***********************************************************************
+ * File layout: a fixed size header followed by a ring of records.
+ * Each record is a fixed size header followed by maxBins floats.
+ **********************************************************************/
+static const char RECORDER_MAGIC[8] = {'P', 'T', 'H', 'S', 'P', 'E', 'C', '1'};
+static const size_t FILE_HEADER_SIZE = 64;
+static const size_t RECORD_HEADER_SIZE = 32;
+
+//file header offsets
+static const size_t MAGIC_OFFSET = 0;
+static const size_t MAX_BINS_OFFSET = 8;
+static const size_t DEPTH_OFFSET = 16;
+static const size_t WRITE_COUNT_OFFSET = 24;
+
+//record header offsets
+static const size_t TIME_OFFSET = 0;
+static const size_t FREQ_OFFSET = 8;
+static const size_t RATE_OFFSET = 16;
+static const size_t NUM_BINS_OFFSET = 24;
+static const size_t FLAGS_OFFSET = 28;
+
+//record flags
+static const uint32_t FLAG_HALF = 1 << 0;
+
+template <typename T>
+static T loadField(const uchar *p)
+{
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template <typename T>
+static void storeField(uchar *p, const T &value)
+{
+    std::memcpy(p, &value, sizeof(value));
+}
+
+SpectrogramRecorder::SpectrogramRecorder(const QString &path, const size_t maxBins, const size_t depth):
+    _file(path),
+    _map(nullptr),
+    _maxBins(maxBins),
+    _depth(std::max<size_t>(depth, 1)),
+    _recordSize(0)
+{
+    if (not _file.open(QIODevice::ReadWrite)) throw Pothos::FileException(
+        "SpectrogramRecorder("+path.toStdString()+")", _file.errorString().toStdString());
+
+    //keep an existing recording with the same depth and room for the bins
+    const QByteArray header = _file.read(FILE_HEADER_SIZE);
+    const auto h = reinterpret_cast<const uchar *>(header.constData());
+    const bool keep = header.size() == int(FILE_HEADER_SIZE) and
+        std::memcmp(h+MAGIC_OFFSET, RECORDER_MAGIC, sizeof(RECORDER_MAGIC)) == 0 and
+        loadField<uint64_t>(h+DEPTH_OFFSET) == _depth and
+        loadField<uint64_t>(h+MAX_BINS_OFFSET) >= _maxBins;
+    if (keep) _maxBins = size_t(loadField<uint64_t>(h+MAX_BINS_OFFSET));
+    _recordSize = RECORD_HEADER_SIZE + _maxBins*sizeof(float);
+
+    //resize the file (sparse on most file systems) and map it
+    const qint64 fileSize = qint64(FILE_HEADER_SIZE + _depth*_recordSize);
+    if (_file.size() != fileSize and not _file.resize(fileSize)) throw Pothos::FileException(
+        "SpectrogramRecorder("+path.toStdString()+")", _file.errorString().toStdString());
+    _map = _file.map(0, fileSize);
+    if (_map == nullptr) throw Pothos::FileException(
+        "SpectrogramRecorder("+path.toStdString()+")", _file.errorString().toStdString());
+
+    //start a new recording unless the existing one was kept
+    if (not keep)
+    {
+        std::memcpy(_map+MAGIC_OFFSET, RECORDER_MAGIC, sizeof(RECORDER_MAGIC));
+        storeField<uint64_t>(_map+MAX_BINS_OFFSET, _maxBins);
+        storeField<uint64_t>(_map+DEPTH_OFFSET, _depth);
+        storeField<uint64_t>(_map+WRITE_COUNT_OFFSET, 0);
+    }
+}
+
+SpectrogramRecorder::~SpectrogramRecorder(void)
+{
+    _file.unmap(_map);
+    _file.close();
+}
+
+uint64_t SpectrogramRecorder::writeCount(void) const
+{
+    return loadField<uint64_t>(_map+WRITE_COUNT_OFFSET);
+}
+
+uchar *SpectrogramRecorder::recordAt(const size_t age) const
+{
+    const uint64_t index = (this->writeCount()-1-age) % _depth;
+    return _map + FILE_HEADER_SIZE + index*_recordSize;
+}
+
+void SpectrogramRecorder::append(const Record &record)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    const uint64_t count = this->writeCount();
+    uchar *p = _map + FILE_HEADER_SIZE + (count % _depth)*_recordSize;
+    const size_t numBins = std::min(record.bins.size(), _maxBins);
+    storeField<double>(p+TIME_OFFSET, record.time);
+    storeField<double>(p+FREQ_OFFSET, record.centerFreq);
+    storeField<double>(p+RATE_OFFSET, record.sampleRate);
+    storeField<uint32_t>(p+NUM_BINS_OFFSET, uint32_t(numBins));
+    storeField<uint32_t>(p+FLAGS_OFFSET, record.half?FLAG_HALF:0);
+    if (numBins != 0) std::memcpy(p+RECORD_HEADER_SIZE, &record.bins[0], numBins*sizeof(float));
+    storeField<uint64_t>(_map+WRITE_COUNT_OFFSET, count+1);
+}
+
+size_t SpectrogramRecorder::size(void) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return size_t(std::min<uint64_t>(this->writeCount(), _depth));
+}
+
+bool SpectrogramRecorder::read(const size_t age, Record &record) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (age >= std::min<uint64_t>(this->writeCount(), _depth)) return false;
+    const uchar *p = this->recordAt(age);
+    record.time = loadField<double>(p+TIME_OFFSET);
+    record.centerFreq = loadField<double>(p+FREQ_OFFSET);
+    record.sampleRate = loadField<double>(p+RATE_OFFSET);
+    record.half = (loadField<uint32_t>(p+FLAGS_OFFSET) & FLAG_HALF) != 0;
+    const size_t numBins = std::min<size_t>(loadField<uint32_t>(p+NUM_BINS_OFFSET), _maxBins);
+    record.bins.resize(numBins);
+    if (numBins != 0) std::memcpy(&record.bins[0], p+RECORD_HEADER_SIZE, numBins*sizeof(float));
+    return true;
+}
+
+double SpectrogramRecorder::timeAt(const size_t age) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (age >= std::min<uint64_t>(this->writeCount(), _depth)) return 0.0;
+    return loadField<double>(this->recordAt(age)+TIME_OFFSET);
+}
+
+size_t SpectrogramRecorder::ageAtTime(const double time) const
+{
+    //binary search, timestamps decrease with age
+    std::unique_lock<std::mutex> lock(_mutex);
+    size_t lo = 0, hi = size_t(std::min<uint64_t>(this->writeCount(), _depth));
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi-lo)/2;
+        if (loadField<double>(this->recordAt(mid)+TIME_OFFSET) > time) lo = mid+1;
+        else hi = mid;
+    }
+    return lo;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2014-2016 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <QFile>
+#include <QString>
+#include <valarray>
+#include <mutex>
+#include <cstdint>
+
+/*!
+ * A ring of spectrogram rows in a memory mapped file.
+ *
+ * Each record holds a timestamp, the center frequency and sample rate,
+ * and the power bins of a row. Only the records that are read or written
+ * are paged into memory, so the depth of the history costs disk, not RAM.
+ *
+ * Records have room for up to maxBins and keep their own number of bins,
+ * so rows of different FFT sizes are kept in the same recording.
+ * An existing file with the same depth and room for at least maxBins
+ * is re-opened and appended to, otherwise a new recording is started.
+ */
+class SpectrogramRecorder
+{
+public:
+    struct Record
+    {
+        double time; //!< seconds since the epoch
+        double centerFreq;
+        double sampleRate;
+        bool half; //!< bins from DC to fs/2 of a real FFT
+        std::valarray<float> bins;
+    };
+
+    //! Open or create a recording file, throws Pothos::FileException
+    SpectrogramRecorder(const QString &path, const size_t maxBins, const size_t depth);
+
+    ~SpectrogramRecorder(void);
+
+    //! The maximum number of bins per record, at least the requested maximum
+    size_t maxBins(void) const
+    {
+        return _maxBins;
+    }
+
+    //! Append a record, overwriting the oldest when full
+    void append(const Record &record);
+
+    //! The number of records available to read
+    size_t size(void) const;
+
+    //! Read a record by age (0 is the newest record)
+    bool read(const size_t age, Record &record) const;
+
+    //! The timestamp of a record by age (0 is the newest record)
+    double timeAt(const size_t age) const;
+
+    //! The age of the newest record at or before the given time
+    size_t ageAtTime(const double time) const;
+
+private:
+    uchar *recordAt(const size_t age) const;
+    uint64_t writeCount(void) const;
+
+    QFile _file;
+    uchar *_map;
+    size_t _maxBins;
+    size_t _depth;
+    size_t _recordSize;
+    mutable std::mutex _mutex;
+};
@@ -0,0 +1,129 @@
+// Copyright (c) 2014-2016 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Exception.hpp>
+#include <valarray>
+#include <string>
+#include <cmath>
+#include <algorithm> //max
+
+/*!
+ * Fold several power spectrums into a single spectrogram row.
+ * Used when the FFT rate exceeds the rate of displayed rows.
+ */
+class SpectrogramRowReducer
+{
+public:
+    SpectrogramRowReducer(void):
+        _mode(MAX),
+        _numPerRow(1),
+        _count(0),
+        _peak(0.0f)
+    {
+        return;
+    }
+
+    //! Set the reduction mode: MAX, MEAN, or PEAK
+    void setMode(const std::string &mode)
+    {
+        if (mode == "MAX") _mode = MAX;
+        else if (mode == "MEAN") _mode = MEAN;
+        else if (mode == "PEAK") _mode = PEAK;
+        else throw Pothos::InvalidArgumentException("SpectrogramRowReducer::setMode("+mode+")", "unknown mode");
+        _count = 0;
+    }
+
+    //! Set the number of power spectrums folded into each row
+    void setNumPerRow(const size_t num)
+    {
+        _numPerRow = std::max<size_t>(num, 1);
+        _count = 0;
+    }
+
+    size_t numPerRow(void) const
+    {
+        return _numPerRow;
+    }
+
+    /*!
+     * Feed a power spectrum (in dB) into the reducer.
+     * Empty power spectrums are ignored.
+     * \return true when a row is complete and available from row()
+     */
+    bool feed(const std::valarray<float> &bins)
+    {
+        if (bins.size() == 0) return false;
+
+        //shortcut when there is nothing to reduce
+        if (_numPerRow == 1)
+        {
+            _row = bins;
+            return true;
+        }
+
+        //start a new row, also restarts after a change in size
+        if (_count == 0 or _row.size() != bins.size())
+        {
+            _count = 0;
+            if (_mode == MEAN) _row = std::pow(10.0f, bins/10.0f);
+            else _row = bins;
+            _peak = bins.max();
+        }
+
+        else if (_mode == MAX)
+        {
+            for (size_t i = 0; i < bins.size(); i++)
+            {
+                _row[i] = std::max(_row[i], bins[i]);
+            }
+        }
+
+        else if (_mode == MEAN)
+        {
+            //accumulate in linear power units
+            for (size_t i = 0; i < bins.size(); i++)
+            {
+                _row[i] += std::pow(10.0f, bins[i]/10.0f);
+            }
+        }
+
+        else if (_mode == PEAK)
+        {
+            //keep the spectrum with the strongest bin
+            const float peak = bins.max();
+            if (peak > _peak)
+            {
+                _row = bins;
+                _peak = peak;
+            }
+        }
+
+        if (++_count < _numPerRow) return false;
+        _count = 0;
+
+        if (_mode == MEAN)
+        {
+            const float scale = 1.0f/_numPerRow;
+            for (size_t i = 0; i < _row.size(); i++)
+            {
+                _row[i] = 10*std::log10(std::max(_row[i]*scale, 1e-20f));
+            }
+        }
+        return true;
+    }
+
+    //! The most recently completed row
+    const std::valarray<float> &row(void) const
+    {
+        return _row;
+    }
+
+private:
+    enum Mode {MAX, MEAN, PEAK};
+    Mode _mode;
+    size_t _numPerRow;
+    size_t _count;
+    float _peak;
+    std::valarray<float> _row;
+};
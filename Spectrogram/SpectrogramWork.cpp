@@ -5,6 +5,8 @@
 #include <qwt_plot.h>
 #include <QTimer>
 #include <complex>
+#include <cmath>
+#include <algorithm> //min/max
 
 /***********************************************************************
  * initialization functions
@@ -24,10 +26,19 @@ void SpectrogramDisplay::deactivate(void)
  **********************************************************************/
 void SpectrogramDisplay::work(void)
 {
-    auto updateRate = this->height()/_timeSpan;
+    if (_streamingMode) return this->workStreaming();
+
+    //the trigger runs fftsPerRow times faster than the rate of displayed rows,
+    //and the time span holds 2^levels - 1 screens of rows from the newest level
+    auto updateRate = this->height()*_rowReducer.numPerRow()*((1 << _timeLevels)-1)/_timeSpan;
     if (updateRate != _lastUpdateRate) this->call("updateRateChanged", updateRate);
     _lastUpdateRate = updateRate;
 
+    //the trigger captures enough samples to decimate and fold down to the FFT size
+    const auto numPoints = this->numInputPoints(std::atomic_load(&_freqZoom));
+    if (numPoints != _lastNumPoints) this->call("numPointsChanged", numPoints);
+    _lastNumPoints = numPoints;
+
     auto inPort = this->input(0);
     if (not inPort->hasMessage()) return;
     const auto msg = inPort->popMessage();
@@ -35,15 +46,7 @@ void SpectrogramDisplay::work(void)
     //label-based messages have in-line commands
     if (msg.type() == typeid(Pothos::Label))
     {
-        const auto &label = msg.convert<Pothos::Label>();
-        if (label.id == _freqLabelId and label.data.canConvert(typeid(double)))
-        {
-            this->setCenterFrequency(label.data.convert<double>());
-        }
-        if (label.id == _rateLabelId and label.data.canConvert(typeid(double)))
-        {
-            this->setSampleRate(label.data.convert<double>());
-        }
+        this->handleLabel(msg.convert<Pothos::Label>());
     }
 
     //packet-based messages have payloads to FFT
@@ -53,20 +56,154 @@ void SpectrogramDisplay::work(void)
         auto floatBuff = buff.convert(Pothos::DType(typeid(std::complex<float>)), buff.elements());
 
         //safe guard against FFT size changes, old buffers could still be in-flight
-        if (floatBuff.elements() != this->numFFTBins()) return;
+        this->updateWorkZoom();
+        const size_t numInput = this->numInputPoints(_workZoom);
+        if (floatBuff.elements() != numInput) return;
 
-        //handle automatic FFT mode
-        if (_fftModeAutomatic)
+        this->handleInputType(buff.dtype);
+
+        //the zoomed band is mixed and decimated down to the FFT size,
+        //each capture is independent so the filter starts from a reset state
+        if (_workZoom)
         {
-            const bool isComplex = buff.dtype.isComplex();
-            const bool changed = _fftModeComplex != isComplex;
-            _fftModeComplex = isComplex;
-            if (changed) QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+            _zoomSamps.clear();
+            _workZoom->reset();
+            _workZoom->feed(floatBuff.as<const std::complex<float> *>(), numInput, _zoomSamps);
+            CArray fftBins(_zoomSamps.data(), _zoomSamps.size());
+            const auto powerBins = this->transformBins(fftBins, false);
+            if (_rowReducer.feed(powerBins)) this->appendBins(_rowReducer.row());
+            return;
         }
 
-        //power bins to points on the curve
-        CArray fftBins(floatBuff.as<const std::complex<float> *>(), this->numFFTBins());
-        const auto powerBins = _fftPowerSpectrum.transform(fftBins, _fullScale);
-        this->appendBins(powerBins);
+        //power bins to points on the curve,
+        //only the unique half of the spectrum is computed in real mode
+        CArray fftBins(floatBuff.as<const std::complex<float> *>(), numInput);
+        const auto powerBins = this->transformBins(fftBins, not (_fftModeComplex or _sweepEnabled));
+        if (_rowReducer.feed(powerBins)) this->appendBins(_rowReducer.row());
+    }
+}
+
+/***********************************************************************
+ * streaming STFT: transform every hop of the continuous input
+ **********************************************************************/
+void SpectrogramDisplay::workStreaming(void)
+{
+    auto inPort = this->input(0);
+
+    //labels have in-line commands
+    for (const auto &label : inPort->labels()) this->handleLabel(label);
+
+    const auto &buff = inPort->buffer();
+    if (buff.elements() == 0) return;
+    this->handleInputType(buff.dtype);
+    const auto floatBuff = buff.convert(Pothos::DType(typeid(std::complex<float>)), buff.elements());
+    inPort->consume(inPort->elements());
+
+    //frames from before a zoom change are from a different band
+    if (this->updateWorkZoom())
+    {
+        _streamSamps.clear();
+        _streamSkip = 0;
+    }
+
+    //the zoomed band is mixed and decimated ahead of the transforms
+    auto samps = floatBuff.as<const std::complex<float> *>();
+    size_t numSamps = floatBuff.elements();
+    if (_workZoom)
+    {
+        _zoomSamps.clear();
+        _workZoom->feed(samps, numSamps, _zoomSamps);
+        samps = _zoomSamps.data();
+        numSamps = _zoomSamps.size();
+    }
+
+    //fold as many transforms into each row as needed to keep up with the row rate
+    const size_t hop = this->hopSize();
+    const double rowRate = this->height()*((1 << _timeLevels)-1)/_timeSpan;
+    const double hopRate = (_workZoom?_workZoom->outputRate():_sampleRate)/hop;
+    const size_t numPerRow = size_t(std::max(std::floor(hopRate/rowRate + 0.5), 1.0));
+    if (numPerRow != _rowReducer.numPerRow()) _rowReducer.setNumPerRow(numPerRow);
+
+    //append the new samples, skipping samples between frames when hop > frame size
+    const size_t skip = std::min(_streamSkip, numSamps);
+    _streamSkip -= skip;
+    _streamSamps.insert(_streamSamps.end(), samps+skip, samps+numSamps);
+
+    //transform each frame, frames overlap by frame size - hop samples,
+    //the polyphase filter bank folds frames of several transforms worth of samples
+    const size_t frameSize = _fftPowerSpectrum.inputSize(this->numFFTBins());
+    size_t offset = 0;
+    while (_streamSamps.size() >= offset + frameSize)
+    {
+        CArray fftBins(_streamSamps.data()+offset, frameSize);
+        const auto powerBins = this->transformBins(fftBins, not (_fftModeComplex or _workZoom or _sweepEnabled));
+        if (_rowReducer.feed(powerBins)) this->appendBins(_rowReducer.row());
+        offset += hop;
+    }
+
+    //keep the unused samples for the next frame
+    const size_t used = std::min(offset, _streamSamps.size());
+    _streamSamps.erase(_streamSamps.begin(), _streamSamps.begin()+used);
+    _streamSkip += offset-used;
+}
+
+/***********************************************************************
+ * shared input handling
+ **********************************************************************/
+std::valarray<float> SpectrogramDisplay::transformBins(CArray &fftBins, const bool halfSpectrum)
+{
+    if (not _powerOutput) return _fftPowerSpectrum.transform(fftBins, _fullScale, halfSpectrum);
+
+    //transform directly into the output buffer, the packet shares it downstream
+    Pothos::BufferChunk buff(typeid(float), _fftPowerSpectrum.outputSize(fftBins.size(), halfSpectrum));
+    if (buff.elements() == 0) return std::valarray<float>();
+    _fftPowerSpectrum.transform(fftBins, buff.as<float *>(), _fullScale, halfSpectrum);
+
+    //the zoomed band is described by the decimated rate and the zoom center
+    Pothos::Packet packet;
+    packet.payload = buff;
+    packet.metadata["format"] = Pothos::Object(std::string("POWER_BINS"));
+    packet.metadata["index"] = Pothos::Object(int(0));
+    packet.metadata["sampleRate"] = Pothos::Object(_workZoom?_workZoom->outputRate():_sampleRate);
+    packet.metadata["centerFreq"] = Pothos::Object(_centerFreq + (_workZoom?_workZoom->offset():0.0));
+    packet.metadata["halfSpectrum"] = Pothos::Object(halfSpectrum);
+    this->output(0)->postMessage(packet);
+
+    return std::valarray<float>(buff.as<const float *>(), buff.elements());
+}
+
+bool SpectrogramDisplay::updateWorkZoom(void)
+{
+    //pick up a zoom change from the GUI thread,
+    //partial rows and detections from the previous band are dropped
+    const auto zoom = std::atomic_load(&_freqZoom);
+    if (zoom == _workZoom) return false;
+    _workZoom = zoom;
+    _rowReducer.setNumPerRow(_rowReducer.numPerRow());
+    _detector.reset();
+    return true;
+}
+
+void SpectrogramDisplay::handleLabel(const Pothos::Label &label)
+{
+    if (label.id == _freqLabelId and label.data.canConvert(typeid(double)))
+    {
+        this->setCenterFrequency(label.data.convert<double>());
+        if (_powerOutput) this->output(0)->postMessage(label);
+    }
+    if (label.id == _rateLabelId and label.data.canConvert(typeid(double)))
+    {
+        this->setSampleRate(label.data.convert<double>());
+        if (_powerOutput) this->output(0)->postMessage(label);
     }
 }
+
+void SpectrogramDisplay::handleInputType(const Pothos::DType &dtype)
+{
+    //handle automatic FFT mode
+    if (not _fftModeAutomatic) return;
+    const bool isComplex = dtype.isComplex();
+    const bool changed = _fftModeComplex != isComplex;
+    _fftModeComplex = isComplex;
+    if (changed) QMetaObject::invokeMethod(this, "handleUpdateAxis", Qt::QueuedConnection);
+}
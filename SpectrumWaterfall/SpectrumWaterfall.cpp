@@ -0,0 +1,409 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "SpectrumWaterfallDisplay.hpp"
+#include "PeriodogramDisplay.hpp"
+#include "SpectrogramDisplay.hpp"
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+
+/***********************************************************************
+ * |PothosDoc Spectrum Waterfall
+ *
+ * The spectrum waterfall plot displays a live power vs frequency trace
+ * above a spectrogram waterfall of the same signal.
+ * A single trigger and spectrum engine feed both plots:
+ * every transform of the waterfall is also drawn on the trace,
+ * so the input is captured, converted, and transformed once.
+ * The frequency axes of the trace and waterfall are linked,
+ * and zooming either plot zooms the other to the same band.
+ *
+ * |category /Plotters
+ * |keywords frequency plot fft dft spectrum spectral waterfall spectrogram periodogram
+ *
+ * |param title The title of the plot
+ * |default "Spectrum Waterfall"
+ * |widget StringEntry()
+ * |preview valid
+ *
+ * |param displayRate[Display Rate] How often the plotter updates.
+ * |default 10.0
+ * |units updates/sec
+ * |preview disable
+ *
+ * |param sampleRate[Sample Rate] The rate of the input elements.
+ * |default 1e6
+ * |units samples/sec
+ *
+ * |param centerFreq[Center Freq] The center frequency of the plot.
+ * This value controls the labeling of the horizontal access.
+ * |default 0.0
+ * |units Hz
+ * |preview valid
+ *
+ * |param numBins[Num FFT Bins] The number of bins per fourier transform.
+ * |default 1024
+ * |option 512
+ * |option 1024
+ * |option 2048
+ * |option 4096
+ * |widget ComboBox(editable=true)
+ * |preview disable
+ * |tab FFT
+ *
+ * |param window[Window Type] The window function controls passband ripple.
+ * |default "hann"
+ * |option [Rectangular] "rectangular"
+ * |option [Hann] "hann"
+ * |option [Hamming] "hamming"
+ * |option [Blackman] "blackman"
+ * |option [Bartlett] "bartlett"
+ * |option [Flat-top] "flattop"
+ * |option [Kaiser] "kaiser"
+ * |option [Chebyshev] "chebyshev"
+ * |option [Polyphase Filter Bank] "pfb"
+ * |preview disable
+ * |tab FFT
+ *
+ * |param windowArgs[Window Args] Optional window arguments (depends on window type).
+ * <ul>
+ * <li>When using the <i>Kaiser</i> window, specify [beta] to use the parameterized Kaiser window.</li>
+ * <li>When using the <i>Chebyshev</i> window, specify [atten] to use the Dolph-Chebyshev window with attenuation in dB.</li>
+ * <li>When using the <i>Polyphase Filter Bank</i>, specify [taps] per branch (default 4).</li>
+ * </ul>
+ * |default []
+ * |preview disable
+ * |tab FFT
+ *
+ * |param fullScale[Full Scale] The amplitude that corresponds to full-scale.
+ * A full-scale amplitude signal will appear as 0.0 dBfs on the plotter.
+ * The default value of 1.0 works best for scaled floating point samples.
+ * A signed 16-bit integer value might use 32768 as full-scale instead.
+ * |default 1.0
+ * |preview disable
+ * |tab FFT
+ *
+ * |param fftMode[FFT Mode] Power spectrum display mode.
+ * <ul>
+ * <li>Real mode ("REAL") displays only the positive frequencies between [0, +fs/2].</li>
+ * <li>Complex mode ("COMPLEX) displays positive and negative frequencies between [-fs/2, +fs/2].</li>
+ * <li>Automatic mode ("AUTO") selects the FFT mode based on the data type of the current signal.</li>
+ * </ul>
+ * |default "AUTO"
+ * |option [Automatic] "AUTO"
+ * |option [Complex] "COMPLEX"
+ * |option [Real] "REAL"
+ * |preview disable
+ * |tab FFT
+ *
+ * |param analysisMode[Analysis Mode] How input samples are selected for the transforms.
+ * <ul>
+ * <li>Triggered ("TRIGGERED") transforms periodic snapshots of the input, one set per displayed row.</li>
+ * <li>Streaming ("STREAMING") transforms the entire input every hop size samples.</li>
+ * </ul>
+ * |default "TRIGGERED"
+ * |option [Triggered] "TRIGGERED"
+ * |option [Streaming] "STREAMING"
+ * |preview disable
+ * |tab FFT
+ *
+ * |param hopSize[Hop Size] The number of samples between transforms in streaming mode.
+ * Zero selects half of the number of bins (50% overlap).
+ * |default 0
+ * |units samples
+ * |widget SpinBox(minimum=0)
+ * |preview disable
+ * |tab FFT
+ *
+ * |param zoomAnalysis[Zoom Analysis] Re-analyze the zoomed band at a finer resolution.
+ * The zoomed band is mixed, decimated, and transformed for both the trace and the waterfall.
+ * |default false
+ * |option [Disable] false
+ * |option [Enable] true
+ * |preview disable
+ * |tab FFT
+ *
+ * |param timeSpan[Time Span] How many seconds of data to display in the waterfall.
+ * |default 10.0
+ * |units seconds
+ * |preview disable
+ * |tab Axis
+ *
+ * |param refLevel[Reference Level] The maximum displayable power level.
+ * |default 0.0
+ * |units dBxx
+ * |widget DoubleSpinBox(minimum=-150, maximum=150, step=10, decimals=1)
+ * |preview disable
+ * |tab Axis
+ *
+ * |param dynRange[Dynamic Range] The ratio of largest to smallest displayable power level.
+ * The trace and the waterfall colors display values from the ref level to ref level - dynamic range.
+ * |default 100.0
+ * |units dB
+ * |widget DoubleSpinBox(minimum=10, maximum=200, step=10, decimals=1)
+ * |preview disable
+ * |tab Axis
+ *
+ * |param averaging[Averaging] Averaging factor for moving average over the trace bins.
+ * A factor of 0.0 means no averaging.
+ * A factor of 1.0 means max averaging.
+ * |default 0.0
+ * |preview disable
+ * |widget DoubleSpinBox(minimum=0.0, maximum=1.0, step=0.05, decimals=3)
+ *
+ * |param traceHeight[Trace Height] The fraction of the plot height used by the trace.
+ * The divider between the trace and the waterfall can also be dragged.
+ * |default 0.4
+ * |widget DoubleSpinBox(minimum=0.1, maximum=0.9, step=0.05, decimals=2)
+ * |preview disable
+ * |tab Axis
+ *
+ * |param colorMap[Color Map] The name of a color map for the waterfall.
+ * |widget ColorMapEntry()
+ * |default "rainbow"
+ * |preview disable
+ * |tab Axis
+ *
+ * |param enableXAxis[Enable X-Axis] Show or hide the horizontal axis markers.
+ * |option [Show] true
+ * |option [Hide] false
+ * |default true
+ * |preview disable
+ * |tab Axis
+ *
+ * |param enableYAxis[Enable Y-Axis] Show or hide the vertical axis markers.
+ * |option [Show] true
+ * |option [Hide] false
+ * |default true
+ * |preview disable
+ * |tab Axis
+ *
+ * |param freqLabelId[Freq Label ID] Labels with this ID can be used to set the center frequency.
+ * To ignore frequency labels, set this parameter to an empty string.
+ * |default "rxFreq"
+ * |widget StringEntry()
+ * |preview disable
+ * |tab Labels
+ *
+ * |param rateLabelId[Rate Label ID] Labels with this ID can be used to set the sample rate.
+ * To ignore sample rate labels, set this parameter to an empty string.
+ * |default "rxRate"
+ * |widget StringEntry()
+ * |preview disable
+ * |tab Labels
+ *
+ * |param startLabelId[Start Label ID] Align captured input to the specified label ID.
+ * An empty label ID disables this feature.
+ * |default ""
+ * |widget StringEntry()
+ * |preview disable
+ * |tab Labels
+ *
+ * |mode graphWidget
+ * |factory /plotters/spectrum_waterfall(remoteEnv)
+ * |initializer setAnalysisMode(analysisMode)
+ * |setter setTitle(title)
+ * |setter setDisplayRate(displayRate)
+ * |setter setSampleRate(sampleRate)
+ * |setter setCenterFrequency(centerFreq)
+ * |setter setNumFFTBins(numBins)
+ * |setter setWindowType(window, windowArgs)
+ * |setter setFullScale(fullScale)
+ * |setter setFFTMode(fftMode)
+ * |setter setHopSize(hopSize)
+ * |setter enableZoomAnalysis(zoomAnalysis)
+ * |setter setTimeSpan(timeSpan)
+ * |setter setReferenceLevel(refLevel)
+ * |setter setDynamicRange(dynRange)
+ * |setter setAverageFactor(averaging)
+ * |setter setTraceHeight(traceHeight)
+ * |setter setColorMap(colorMap)
+ * |setter enableXAxis(enableXAxis)
+ * |setter enableYAxis(enableYAxis)
+ * |setter setFreqLabelId(freqLabelId)
+ * |setter setRateLabelId(rateLabelId)
+ * |setter setStartLabelId(startLabelId)
+ **********************************************************************/
+class SpectrumWaterfall : public Pothos::Topology
+{
+public:
+    static Topology *make(const Pothos::ProxyEnvironment::Sptr &remoteEnv)
+    {
+        return new SpectrumWaterfall(remoteEnv);
+    }
+
+    SpectrumWaterfall(const Pothos::ProxyEnvironment::Sptr &remoteEnv):
+        _streaming(false)
+    {
+        _waterfall.reset(new SpectrogramDisplay());
+        _waterfall->setName("Waterfall");
+        _trace.reset(new PeriodogramDisplay());
+        _trace->setName("Trace");
+        _display.reset(new SpectrumWaterfallDisplay(_trace.get(), _waterfall.get()));
+
+        //the waterfall transforms the input and forwards the power bins to the trace,
+        //the trace draws the bins of the band the waterfall transformed
+        _waterfall->enablePowerOutput(true);
+        _trace->enableZoomAnalysis(false);
+
+        auto registry = remoteEnv->findProxy("Pothos/BlockRegistry");
+        _trigger = registry.call("/comms/wave_trigger");
+        _trigger.call("setName", "Trigger");
+        _trigger.call("setMode", "PERIODIC");
+
+        //register calls in this topology
+        this->registerCall(this, POTHOS_FCN_TUPLE(SpectrumWaterfall, widget));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SpectrumWaterfall, setTitle));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SpectrumWaterfall, setTraceHeight));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SpectrumWaterfall, setNumFFTBins));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SpectrumWaterfall, setFreqLabelId));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SpectrumWaterfall, setRateLabelId));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SpectrumWaterfall, setStartLabelId));
+        this->registerCall(this, POTHOS_FCN_TUPLE(SpectrumWaterfall, setAnalysisMode));
+
+        //connect to the internal display blocks
+        this->connect(this, "setDisplayRate", _waterfall, "setDisplayRate");
+        this->connect(this, "setSampleRate", _waterfall, "setSampleRate");
+        this->connect(this, "setSampleRate", _trace, "setSampleRate");
+        this->connect(this, "setCenterFrequency", _waterfall, "setCenterFrequency");
+        this->connect(this, "setCenterFrequency", _trace, "setCenterFrequency");
+        this->connect(this, "setWindowType", _waterfall, "setWindowType");
+        this->connect(this, "setFullScale", _waterfall, "setFullScale");
+        this->connect(this, "setFFTMode", _waterfall, "setFFTMode");
+        this->connect(this, "setFFTMode", _trace, "setFFTMode");
+        this->connect(this, "setHopSize", _waterfall, "setHopSize");
+        this->connect(this, "enableZoomAnalysis", _waterfall, "enableZoomAnalysis");
+        this->connect(this, "setTimeSpan", _waterfall, "setTimeSpan");
+        this->connect(this, "setReferenceLevel", _waterfall, "setReferenceLevel");
+        this->connect(this, "setReferenceLevel", _trace, "setReferenceLevel");
+        this->connect(this, "setDynamicRange", _waterfall, "setDynamicRange");
+        this->connect(this, "setDynamicRange", _trace, "setDynamicRange");
+        this->connect(this, "setAverageFactor", _trace, "setAverageFactor");
+        this->connect(this, "setColorMap", _waterfall, "setColorMap");
+        this->connect(this, "enableXAxis", _waterfall, "enableXAxis");
+        this->connect(this, "enableXAxis", _trace, "enableXAxis");
+        this->connect(this, "enableYAxis", _waterfall, "enableYAxis");
+        this->connect(this, "enableYAxis", _trace, "enableYAxis");
+        this->connect(_waterfall, "frequencySelected", this, "frequencySelected");
+        this->connect(_waterfall, "relativeFrequencySelected", this, "relativeFrequencySelected");
+        this->connect(_trace, "frequencySelected", this, "frequencySelected");
+        this->connect(_trace, "relativeFrequencySelected", this, "relativeFrequencySelected");
+
+        //connect to the internal snooper block
+        this->connect(_waterfall, "updateRateChanged", _trigger, "setEventRate");
+        this->connect(_waterfall, "numPointsChanged", _trigger, "setNumPoints");
+
+        //connect stream ports
+        this->connect(this, 0, _trigger, 0);
+        this->connect(_trigger, 0, _waterfall, 0);
+        this->connect(_waterfall, 0, _trace, 0);
+    }
+
+    Pothos::Object opaqueCallMethod(const std::string &name, const Pothos::Object *inputArgs, const size_t numArgs) const
+    {
+        //calls that go to the topology
+        try
+        {
+            return Pothos::Topology::opaqueCallMethod(name, inputArgs, numArgs);
+        }
+        catch (const Pothos::BlockCallNotFound &){}
+
+        //calls that go to the waterfall, which owns the spectrum engine
+        try
+        {
+            return _waterfall->opaqueCallMethod(name, inputArgs, numArgs);
+        }
+        catch (const Pothos::BlockCallNotFound &){}
+
+        //forward everything else to the trace
+        return _trace->opaqueCallMethod(name, inputArgs, numArgs);
+    }
+
+    QWidget *widget(void)
+    {
+        return _display.get();
+    }
+
+    void setTitle(const QString &title)
+    {
+        _trace->setTitle(title);
+    }
+
+    void setTraceHeight(const double fraction)
+    {
+        _display->setTraceHeight(fraction);
+    }
+
+    void setNumFFTBins(const size_t num)
+    {
+        //the waterfall emits the capture size to the trigger from its work,
+        //which includes the filter bank taps and the zoom decimation
+        _waterfall->setNumFFTBins(num);
+    }
+
+    void setAnalysisMode(const std::string &mode)
+    {
+        _waterfall->setAnalysisMode(mode);
+
+        //streaming mode bypasses the trigger, the waterfall consumes the entire input
+        if (mode == "STREAMING" and not _streaming)
+        {
+            this->disconnect(this, 0, _trigger, 0);
+            this->disconnect(_trigger, 0, _waterfall, 0);
+            this->connect(this, 0, _waterfall, 0);
+        }
+        if (mode == "TRIGGERED" and _streaming)
+        {
+            this->disconnect(this, 0, _waterfall, 0);
+            this->connect(this, 0, _trigger, 0);
+            this->connect(_trigger, 0, _waterfall, 0);
+        }
+        _streaming = (mode == "STREAMING");
+    }
+
+    void setFreqLabelId(const std::string &id)
+    {
+        //the waterfall forwards the labels to the trace
+        _waterfall->setFreqLabelId(id);
+        _trace->setFreqLabelId(id);
+        _freqLabelId = id;
+        this->updateIdsList();
+    }
+
+    void setRateLabelId(const std::string &id)
+    {
+        _waterfall->setRateLabelId(id);
+        _trace->setRateLabelId(id);
+        _rateLabelId = id;
+        this->updateIdsList();
+    }
+
+    void setStartLabelId(const std::string &id)
+    {
+        _trigger.call("setLabelId", id);
+        _trigger.call("setMode", id.empty()?"PERIODIC":"NORMAL");
+    }
+
+    void updateIdsList(void)
+    {
+        std::vector<std::string> ids;
+        if (not _freqLabelId.empty()) ids.push_back(_freqLabelId);
+        if (not _rateLabelId.empty()) ids.push_back(_rateLabelId);
+        _trigger.call("setIdsList", ids);
+    }
+
+private:
+    //the layout widget is destroyed after the displays it contains
+    std::shared_ptr<SpectrumWaterfallDisplay> _display;
+    Pothos::Proxy _trigger;
+    std::shared_ptr<SpectrogramDisplay> _waterfall;
+    std::shared_ptr<PeriodogramDisplay> _trace;
+    std::string _freqLabelId, _rateLabelId;
+    bool _streaming;
+};
+
+/***********************************************************************
+ * registration
+ **********************************************************************/
+static Pothos::BlockRegistry registerSpectrumWaterfall(
+    "/plotters/spectrum_waterfall", &SpectrumWaterfall::make);
@@ -0,0 +1,97 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "SpectrumWaterfallDisplay.hpp"
+#include "PeriodogramDisplay.hpp"
+#include "SpectrogramDisplay.hpp"
+#include <qwt_plot_zoomer.h>
+#include <QSplitter>
+#include <QHBoxLayout>
+#include <algorithm> //min/max
+
+SpectrumWaterfallDisplay::SpectrumWaterfallDisplay(PeriodogramDisplay *trace, SpectrogramDisplay *waterfall):
+    _trace(trace),
+    _waterfall(waterfall),
+    _splitter(new QSplitter(Qt::Vertical, this)),
+    _traceHeight(0.4),
+    _linking(false)
+{
+    //layout
+    auto layout = new QHBoxLayout(this);
+    layout->setSpacing(0);
+    layout->setContentsMargins(QMargins());
+    layout->addWidget(_splitter);
+    _splitter->addWidget(_trace);
+    _splitter->addWidget(_waterfall);
+    _splitter->setChildrenCollapsible(false);
+    this->handleUpdateSizes();
+
+    //link the frequency axis zoom
+    connect(_trace->zoomer(), SIGNAL(zoomed(const QRectF &)), this, SLOT(handleTraceZoomed(const QRectF &)));
+    connect(_waterfall->zoomer(), SIGNAL(zoomed(const QRectF &)), this, SLOT(handleWaterfallZoomed(const QRectF &)));
+}
+
+void SpectrumWaterfallDisplay::setTraceHeight(const double fraction)
+{
+    _traceHeight = std::min(std::max(fraction, 0.1), 0.9);
+    QMetaObject::invokeMethod(this, "handleUpdateSizes", Qt::QueuedConnection);
+}
+
+void SpectrumWaterfallDisplay::handleUpdateSizes(void)
+{
+    //the splitter scales the sizes to the available height
+    QList<int> sizes;
+    sizes.append(int(1000*_traceHeight));
+    sizes.append(int(1000*(1.0-_traceHeight)));
+    _splitter->setSizes(sizes);
+}
+
+QVariant SpectrumWaterfallDisplay::saveState(void) const
+{
+    QVariantMap map;
+    map["trace"] = _trace->saveState();
+    map["waterfall"] = _waterfall->saveState();
+    map["splitter"] = _splitter->saveState();
+    return map;
+}
+
+void SpectrumWaterfallDisplay::restoreState(const QVariant &state)
+{
+    const auto map = state.toMap();
+    _trace->restoreState(map["trace"]);
+    _waterfall->restoreState(map["waterfall"]);
+    _splitter->restoreState(map["splitter"].toByteArray());
+}
+
+void SpectrumWaterfallDisplay::handleTraceZoomed(const QRectF &rect)
+{
+    this->linkZoom(_trace->zoomer(), _waterfall->zoomer(), rect);
+}
+
+void SpectrumWaterfallDisplay::handleWaterfallZoomed(const QRectF &rect)
+{
+    this->linkZoom(_waterfall->zoomer(), _trace->zoomer(), rect);
+}
+
+void SpectrumWaterfallDisplay::linkZoom(QwtPlotZoomer *from, QwtPlotZoomer *to, const QRectF &rect)
+{
+    //the linked zoom emits zoomed on the other plot, which would come back here
+    if (_linking) return;
+    _linking = true;
+
+    //zooming all the way out returns both plots to their base,
+    //otherwise only the horizontal (frequency) range is applied to the other plot
+    if (from->zoomRectIndex() == 0)
+    {
+        if (to->zoomRectIndex() != 0) to->zoom(0);
+    }
+    else
+    {
+        auto toRect = to->zoomRect();
+        toRect.setLeft(rect.left());
+        toRect.setRight(rect.right());
+        if (toRect != to->zoomRect()) to->zoom(toRect);
+    }
+
+    _linking = false;
+}
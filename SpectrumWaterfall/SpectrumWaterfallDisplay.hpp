@@ -0,0 +1,58 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <QVariant>
+#include <QWidget>
+#include <QRectF>
+
+class QSplitter;
+class QwtPlotZoomer;
+class PeriodogramDisplay;
+class SpectrogramDisplay;
+
+/*!
+ * Stack a periodogram trace over a spectrogram waterfall.
+ * The displays are owned by the topology, this widget only lays them out
+ * and keeps the frequency axis zoom of the trace and waterfall in step.
+ */
+class SpectrumWaterfallDisplay : public QWidget
+{
+    Q_OBJECT
+public:
+
+    SpectrumWaterfallDisplay(PeriodogramDisplay *trace, SpectrogramDisplay *waterfall);
+
+    //! The fraction of the height used by the trace in [0.1, 0.9]
+    void setTraceHeight(const double fraction);
+
+    //allow for standard resize controls with the default size policy
+    QSize minimumSizeHint(void) const
+    {
+        return QSize(300, 300);
+    }
+    QSize sizeHint(void) const
+    {
+        return this->minimumSizeHint();
+    }
+
+public slots:
+
+    QVariant saveState(void) const;
+
+    void restoreState(const QVariant &value);
+
+private slots:
+    void handleUpdateSizes(void);
+    void handleTraceZoomed(const QRectF &rect);
+    void handleWaterfallZoomed(const QRectF &rect);
+
+private:
+    void linkZoom(QwtPlotZoomer *from, QwtPlotZoomer *to, const QRectF &rect);
+
+    PeriodogramDisplay *_trace;
+    SpectrogramDisplay *_waterfall;
+    QSplitter *_splitter;
+    double _traceHeight;
+    bool _linking; //!< a linked zoom is being applied
+};
@@ -47,6 +47,8 @@
  * |preview disable
  *
  * |param autoScale[Auto-Scale] Enable automatic scaling for the vertical axis.
+ * The axis expands as soon as the visible curves leave it,
+ * and shrinks only when the curves span less than half of it.
  * |default true
  * |option [Auto scale] true
  * |option [Use limits] false
@@ -216,16 +216,41 @@ void WaveMonitorDisplay::handleZoomed(const QRectF &rect)
     //when zoomed all the way out, return to autoscale
     if (rect == _mainPlot->zoomer()->zoomBase() and _autoScale)
     {
-        _mainPlot->setAxisAutoScale(QwtPlot::yLeft);
-        _mainPlot->updateAxes(); //update after axis changes
+        _autoScaler.reset();
+        this->updateAutoScale();
     }
 }
 
+void WaveMonitorDisplay::updateAutoScale(void)
+{
+    if (not _autoScale or _mainPlot->zoomer()->zoomRectIndex() != 0) return;
+
+    //the bounds were tracked as the samples were written,
+    //so qwt does not rescan every sample for an autoscaled axis
+    QwtInterval bounds;
+    for (const auto &pair : _curves)
+    {
+        for (const auto &curvePair : pair.second)
+        {
+            if (curvePair.second->isVisible()) bounds |= _curveBounds[pair.first][curvePair.first];
+        }
+    }
+    if (not bounds.isValid()) return;
+    if (not _autoScaler.update(bounds.minValue(), bounds.maxValue())) return;
+
+    //the zoom base follows the scale so that zooming out returns to it
+    _mainPlot->setAxisScale(QwtPlot::yLeft, _autoScaler.lower(), _autoScaler.upper());
+    _mainPlot->updateAxes(); //update after axis changes
+    _mainPlot->zoomer()->setZoomBase(false);
+}
+
 void WaveMonitorDisplay::handleClearChannels(void)
 {
     _curves.clear();
+    _curveBounds.clear();
     _markers.clear();
     _curveCount = 0;
+    _autoScaler.reset();
 }
 
 QVariant WaveMonitorDisplay::saveState(void) const
@@ -268,6 +293,7 @@ QwtPlotCurve *WaveMonitorDisplay::getCurve(const size_t index, const size_t whic
     {
         _curveCount -= curves.size();
         curves.clear();
+        _curveBounds[index].clear();
         if (_curveCount <= 1) _mainPlot->insertLegend(nullptr);
     }
 
@@ -11,6 +11,8 @@
 #include <atomic>
 #include <vector>
 #include <qwt_text.h>
+#include <qwt_interval.h>
+#include "PothosAutoScaler.hpp"
 
 class PothosPlotter;
 class QwtPlotCurve;
@@ -117,12 +119,14 @@ private slots:
 
 private:
     QwtPlotCurve *getCurve(const size_t index, const size_t which, const size_t width);
+    void updateAutoScale(void);
 
     PothosPlotter *_mainPlot;
     double _sampleRate;
     double _sampleRateWoAxisUnits;
     size_t _numPoints;
     bool _autoScale;
+    PothosAutoScaler _autoScaler; //!< only used by the GUI thread
     std::vector<double> _yRange;
     std::string _rateLabelId;
     QwtText _triggerMarkerLabel;
@@ -134,6 +138,7 @@ private:
     //per-port data structs
     size_t _curveCount;
     std::map<size_t, std::map<size_t, std::unique_ptr<QwtPlotCurve>>> _curves;
+    std::map<size_t, std::map<size_t, QwtInterval>> _curveBounds;
     std::map<size_t, std::vector<std::unique_ptr<QwtPlotMarker>>> _markers;
     std::map<size_t, std::unique_ptr<std::atomic<size_t>>> _queueDepth;
 };
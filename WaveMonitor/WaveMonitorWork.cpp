@@ -8,6 +8,8 @@
 #include <qwt_plot_marker.h>
 #include <qwt_plot.h>
 #include <complex>
+#include <algorithm> //min/max
+#include <limits>
 #include <iostream>
 
 /***********************************************************************
@@ -29,8 +31,10 @@ void WaveMonitorDisplay::handleSamples(const Pothos::Packet &packet)
     const auto levelIt = packet.metadata.find("level");
     const auto level = (levelIt == packet.metadata.end())?0:levelIt->second.convert<qreal>();
 
-    //extract and convert buffer
+    //extract and convert buffer,
+    //the bounds of each curve are tracked in the same pass for the autoscale
     const auto &buff = packet.payload;
+    const float inf = std::numeric_limits<float>::infinity();
     Pothos::BufferChunk buffI, buffQ;
     if (buff.dtype.isComplex())
     {
@@ -40,26 +44,37 @@ void WaveMonitorDisplay::handleSamples(const Pothos::Packet &packet)
         const auto sampsQ = outs.second.as<const float *>();
         QVector<QPointF> pointsI(buff.elements());
         QVector<QPointF> pointsQ(buff.elements());
+        float loI(inf), hiI(-inf), loQ(inf), hiQ(-inf);
         for (int i = 0; i < pointsI.size(); i++)
         {
             const auto x = (i-frac)/_sampleRateWoAxisUnits;
             pointsI[i] = QPointF(x, sampsI[i]);
             pointsQ[i] = QPointF(x, sampsQ[i]);
+            loI = std::min(loI, sampsI[i]);
+            hiI = std::max(hiI, sampsI[i]);
+            loQ = std::min(loQ, sampsQ[i]);
+            hiQ = std::max(hiQ, sampsQ[i]);
         }
         this->getCurve(index, 0, 2)->setSamples(pointsI);
         this->getCurve(index, 1, 2)->setSamples(pointsQ);
+        _curveBounds[index][0] = QwtInterval(loI, hiI);
+        _curveBounds[index][1] = QwtInterval(loQ, hiQ);
     }
     else
     {
         buffI = buff.convert(typeid(float));
         const auto samps = buffI.as<const float *>();
         QVector<QPointF> points(buff.elements());
+        float lo(inf), hi(-inf);
         for (int i = 0; i < points.size(); i++)
         {
             const auto x = (i-frac)/_sampleRateWoAxisUnits;
             points[i] = QPointF(x, samps[i]);
+            lo = std::min(lo, samps[i]);
+            hi = std::max(hi, samps[i]);
         }
         this->getCurve(index, 0, 1)->setSamples(points);
+        _curveBounds[index][0] = QwtInterval(lo, hi);
     }
 
     //create markers from labels
@@ -86,6 +101,7 @@ void WaveMonitorDisplay::handleSamples(const Pothos::Packet &packet)
         }
     }
 
+    this->updateAutoScale();
     _mainPlot->replot();
 }
 
@@ -0,0 +1,32 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+/*!
+ * Minimal checks for the unit tests of the Qt-free plotter utilities.
+ * A failed check prints its location and exits with a failure status,
+ * which ctest reports as a failed test.
+ */
+#define PLOTTERS_TEST_TRUE(statement) \
+    do { \
+        if (not (statement)) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #statement << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+#define PLOTTERS_TEST_CLOSE(lhs, rhs, tol) \
+    do { \
+        const double lhs_ = (lhs), rhs_ = (rhs); \
+        if (not (std::abs(lhs_ - rhs_) <= (tol))) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #lhs << " == " << #rhs \
+                << " (" << lhs_ << " vs " << rhs_ << ", tolerance " << (tol) << ")" << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
@@ -0,0 +1,92 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PlottersTest.hpp"
+#include "PothosAutoScaler.hpp"
+#include <limits>
+
+static void testFirstUpdate(void)
+{
+    //the first update fits the scale to the data with the margin
+    PothosAutoScaler scaler;
+    PLOTTERS_TEST_TRUE(not scaler.isValid());
+    PLOTTERS_TEST_TRUE(scaler.update(-10.0, 10.0));
+    PLOTTERS_TEST_TRUE(scaler.isValid());
+    PLOTTERS_TEST_CLOSE(scaler.lower(), -11.0, 1e-9);
+    PLOTTERS_TEST_CLOSE(scaler.upper(), 11.0, 1e-9);
+}
+
+static void testHysteresis(void)
+{
+    PothosAutoScaler scaler;
+    scaler.setMargin(0.0);
+    scaler.setShrinkFraction(0.5);
+    PLOTTERS_TEST_TRUE(scaler.update(0.0, 100.0));
+
+    //data inside the scale that fills enough of it keeps the scale
+    PLOTTERS_TEST_TRUE(not scaler.update(10.0, 90.0));
+    PLOTTERS_TEST_TRUE(not scaler.update(0.0, 50.0));
+    PLOTTERS_TEST_CLOSE(scaler.lower(), 0.0, 0.0);
+    PLOTTERS_TEST_CLOSE(scaler.upper(), 100.0, 0.0);
+
+    //the scale expands as soon as the data leaves it
+    PLOTTERS_TEST_TRUE(scaler.update(0.0, 101.0));
+    PLOTTERS_TEST_CLOSE(scaler.upper(), 101.0, 0.0);
+    PLOTTERS_TEST_TRUE(scaler.update(-1.0, 50.0));
+    PLOTTERS_TEST_CLOSE(scaler.lower(), -1.0, 0.0);
+    PLOTTERS_TEST_CLOSE(scaler.upper(), 50.0, 0.0);
+
+    //and shrinks when the data spans less than the shrink fraction
+    PLOTTERS_TEST_TRUE(not scaler.update(0.0, 26.0));
+    PLOTTERS_TEST_TRUE(scaler.update(0.0, 25.0));
+    PLOTTERS_TEST_CLOSE(scaler.lower(), 0.0, 0.0);
+    PLOTTERS_TEST_CLOSE(scaler.upper(), 25.0, 0.0);
+}
+
+static void testInvalidBounds(void)
+{
+    //non-finite or inverted bounds leave the scale alone
+    PothosAutoScaler scaler;
+    PLOTTERS_TEST_TRUE(not scaler.update(1.0, 0.0));
+    PLOTTERS_TEST_TRUE(not scaler.update(0.0, std::numeric_limits<double>::infinity()));
+    PLOTTERS_TEST_TRUE(not scaler.update(std::numeric_limits<double>::quiet_NaN(), 0.0));
+    PLOTTERS_TEST_TRUE(not scaler.isValid());
+}
+
+static void testFlatData(void)
+{
+    //flat data gets a margin around its level
+    PothosAutoScaler scaler;
+    PLOTTERS_TEST_TRUE(scaler.update(-50.0, -50.0));
+    PLOTTERS_TEST_TRUE(scaler.lower() < -50.0);
+    PLOTTERS_TEST_TRUE(scaler.upper() > -50.0);
+    PLOTTERS_TEST_CLOSE(scaler.upper() - (-50.0), -50.0 - scaler.lower(), 1e-9);
+
+    //including a flat zero
+    scaler.reset();
+    PLOTTERS_TEST_TRUE(scaler.update(0.0, 0.0));
+    PLOTTERS_TEST_TRUE(scaler.upper() > scaler.lower());
+}
+
+static void testReset(void)
+{
+    //a reset fits the scale to the next update even inside the old scale
+    PothosAutoScaler scaler;
+    scaler.setMargin(0.0);
+    PLOTTERS_TEST_TRUE(scaler.update(0.0, 100.0));
+    scaler.reset();
+    PLOTTERS_TEST_TRUE(not scaler.isValid());
+    PLOTTERS_TEST_TRUE(scaler.update(10.0, 90.0));
+    PLOTTERS_TEST_CLOSE(scaler.lower(), 10.0, 0.0);
+    PLOTTERS_TEST_CLOSE(scaler.upper(), 90.0, 0.0);
+}
+
+int main(void)
+{
+    testFirstUpdate();
+    testHysteresis();
+    testInvalidBounds();
+    testFlatData();
+    testReset();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PlottersTest.hpp"
+#include "PothosPlotterFFTUtils.hpp"
+#include <random>
+
+//direct evaluation of the DFT sum in double precision
+static std::vector<std::complex<double>> referenceDFT(const CArray &x)
+{
+    const size_t N = x.size();
+    std::vector<std::complex<double>> X(N);
+    for (size_t k = 0; k < N; k++)
+    {
+        for (size_t n = 0; n < N; n++)
+        {
+            X[k] += std::complex<double>(x[n]) * std::polar(1.0, -2*M_PI*double((k*n) % N)/N);
+        }
+    }
+    return X;
+}
+
+static CArray randomInput(const size_t N, std::mt19937 &rng)
+{
+    std::normal_distribution<float> dist;
+    CArray x(N);
+    for (size_t n = 0; n < N; n++) x[n] = Complex(dist(rng), dist(rng));
+    return x;
+}
+
+static void checkPlan(FFTPlan &plan, const size_t N, std::mt19937 &rng)
+{
+    const auto x = randomInput(N, rng);
+    const auto X = referenceDFT(x);
+    CArray y(x);
+    plan(y);
+
+    //single precision error grows with log2(N), scaled by the rms of the output
+    const double tol = 1e-5*std::sqrt(double(N))*(1+std::log2(double(N)));
+    for (size_t k = 0; k < N; k++)
+    {
+        PLOTTERS_TEST_CLOSE(y[k].real(), X[k].real(), tol);
+        PLOTTERS_TEST_CLOSE(y[k].imag(), X[k].imag(), tol);
+    }
+}
+
+static void testSizes(void)
+{
+    std::mt19937 rng(0);
+    FFTPlan plan;
+    for (size_t N = 1; N <= 1024; N *= 2) checkPlan(plan, N, rng);
+
+    //the plan is recomputed when the size changes back and forth
+    checkPlan(plan, 64, rng);
+    checkPlan(plan, 16, rng);
+    checkPlan(plan, 64, rng);
+}
+
+static void testMatchesRecursive(void)
+{
+    std::mt19937 rng(1);
+    FFTPlan plan;
+    auto x = randomInput(256, rng);
+    CArray y(x);
+    fft(x);
+    plan(y);
+    for (size_t k = 0; k < x.size(); k++) PLOTTERS_TEST_CLOSE(std::abs(y[k]-x[k]), 0.0, 1e-3);
+}
+
+static void testTone(void)
+{
+    //a complex tone on a bin center lands entirely in that bin
+    const size_t N = 512, bin = 37;
+    CArray x(N);
+    for (size_t n = 0; n < N; n++) x[n] = Complex(std::polar(1.0, 2*M_PI*double(bin*n)/N));
+    FFTPlan plan;
+    plan(x);
+    for (size_t k = 0; k < N; k++) PLOTTERS_TEST_CLOSE(std::abs(x[k]), (k == bin)?double(N):0.0, 1e-2);
+}
+
+int main(void)
+{
+    testSizes();
+    testMatchesRecursive();
+    testTone();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PlottersTest.hpp"
+#include "PothosPlotterFFTUtils.hpp"
+#include <random>
+
+static const size_t NUM_BINS = 256;
+
+//mean power in dB of the bins over many transforms of complex white noise
+static double noiseLevel(FFTPowerSpectrum &fft, const double sigma)
+{
+    std::mt19937 rng(0);
+    std::normal_distribution<float> dist(0.0f, float(sigma));
+    const size_t numFrames = 200;
+    double sum = 0.0;
+    for (size_t i = 0; i < numFrames; i++)
+    {
+        CArray x(fft.inputSize(NUM_BINS));
+        for (auto &v : x) v = Complex(dist(rng), dist(rng));
+        const auto powerBins = fft.transform(x);
+        PLOTTERS_TEST_TRUE(powerBins.size() == NUM_BINS);
+        for (const auto p : powerBins) sum += std::pow(10.0, p/10.0);
+    }
+    return 10*std::log10(sum/(numFrames*NUM_BINS));
+}
+
+static void testSizes(void)
+{
+    //taps*N input samples are folded into N bins
+    FFTPowerSpectrum fft;
+    fft.setWindowType("pfb", std::vector<double>(1, 8.0));
+    PLOTTERS_TEST_TRUE(fft.inputSize(NUM_BINS) == 8*NUM_BINS);
+    PLOTTERS_TEST_TRUE(fft.outputSize(8*NUM_BINS) == NUM_BINS);
+    PLOTTERS_TEST_TRUE(fft.outputSize(8*NUM_BINS, true) == NUM_BINS/2+1);
+
+    //the default is 4 taps per branch
+    fft.setWindowType("pfb", std::vector<double>());
+    PLOTTERS_TEST_TRUE(fft.inputSize(NUM_BINS) == 4*NUM_BINS);
+
+    //fewer samples than taps transform into nothing
+    CArray x(3);
+    PLOTTERS_TEST_TRUE(fft.transform(x).size() == 0);
+}
+
+static void testFoldGain(void)
+{
+    //the gain uses the rms of the prototype filter per branch
+    FFTPowerSpectrum fft;
+    fft.setWindowType("pfb", std::vector<double>());
+    CArray x(fft.inputSize(NUM_BINS));
+    fft.transform(x);
+
+    const size_t L = fft.inputSize(NUM_BINS);
+    const auto window = spuce::design_window("hamming", L, 0.0);
+    double energy = 0.0;
+    for (size_t n = 0; n < L; n++)
+    {
+        const double t = (double(n) - L/2.0)/NUM_BINS;
+        const double sinc = (t == 0.0)?1.0:std::sin(M_PI*t)/(M_PI*t);
+        energy += std::pow(sinc*window[n], 2);
+    }
+    const double expected = 20*std::log10(double(NUM_BINS)) + 10*std::log10(energy/NUM_BINS) + 20*std::log10(2.0);
+    PLOTTERS_TEST_CLOSE(fft.gainDB(NUM_BINS, 2.0), expected, 1e-3);
+}
+
+static void testNoiseFloor(void)
+{
+    //the filter bank and a window report the same white noise density,
+    //the folded samples must not be windowed a second time
+    const double sigma = 0.5;
+    const double expected = 10*std::log10(2*sigma*sigma/NUM_BINS);
+
+    FFTPowerSpectrum windowed;
+    windowed.setWindowType("hann", std::vector<double>());
+    PLOTTERS_TEST_CLOSE(noiseLevel(windowed, sigma), expected, 0.1);
+
+    FFTPowerSpectrum pfb;
+    pfb.setWindowType("pfb", std::vector<double>());
+    PLOTTERS_TEST_CLOSE(noiseLevel(pfb, sigma), expected, 0.1);
+
+    //switching back to a window restores the window gain
+    pfb.setWindowType("hann", std::vector<double>());
+    PLOTTERS_TEST_CLOSE(noiseLevel(pfb, sigma), expected, 0.1);
+}
+
+static void testLeakage(void)
+{
+    //a tone on a bin center stays out of the neighboring bins
+    FFTPowerSpectrum fft;
+    fft.setWindowType("pfb", std::vector<double>());
+    CArray x(fft.inputSize(NUM_BINS));
+    for (size_t n = 0; n < x.size(); n++) x[n] = Complex(std::polar(1.0, 2*M_PI*64.0*n/NUM_BINS));
+    const auto powerBins = fft.transform(x);
+    const float peak = powerBins[NUM_BINS/2+64];
+    PLOTTERS_TEST_TRUE(peak == powerBins.max());
+    PLOTTERS_TEST_TRUE(powerBins[NUM_BINS/2+65] < peak - 40);
+    PLOTTERS_TEST_TRUE(powerBins[NUM_BINS/2+74] < peak - 80);
+}
+
+int main(void)
+{
+    testSizes();
+    testFoldGain();
+    testNoiseFloor();
+    testLeakage();
+    return EXIT_SUCCESS;
+}
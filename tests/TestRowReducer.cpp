@@ -0,0 +1,117 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PlottersTest.hpp"
+#include "SpectrogramRowReducer.hpp"
+
+static std::valarray<float> makeBins(const float a, const float b, const float c)
+{
+    std::valarray<float> bins(3);
+    bins[0] = a;
+    bins[1] = b;
+    bins[2] = c;
+    return bins;
+}
+
+static void testPassThrough(void)
+{
+    SpectrogramRowReducer reducer;
+    PLOTTERS_TEST_TRUE(reducer.numPerRow() == 1);
+    PLOTTERS_TEST_TRUE(reducer.feed(makeBins(-10, -20, -30)));
+    PLOTTERS_TEST_CLOSE(reducer.row()[1], -20, 0.0);
+}
+
+static void testMax(void)
+{
+    SpectrogramRowReducer reducer;
+    reducer.setMode("MAX");
+    reducer.setNumPerRow(3);
+    PLOTTERS_TEST_TRUE(not reducer.feed(makeBins(-10, -50, -30)));
+    PLOTTERS_TEST_TRUE(not reducer.feed(makeBins(-40, -20, -60)));
+    PLOTTERS_TEST_TRUE(reducer.feed(makeBins(-70, -80, -5)));
+    PLOTTERS_TEST_CLOSE(reducer.row()[0], -10, 0.0);
+    PLOTTERS_TEST_CLOSE(reducer.row()[1], -20, 0.0);
+    PLOTTERS_TEST_CLOSE(reducer.row()[2], -5, 0.0);
+
+    //the next row starts over
+    PLOTTERS_TEST_TRUE(not reducer.feed(makeBins(-90, -90, -90)));
+}
+
+static void testMean(void)
+{
+    //the mean is taken in linear power units
+    SpectrogramRowReducer reducer;
+    reducer.setMode("MEAN");
+    reducer.setNumPerRow(2);
+    PLOTTERS_TEST_TRUE(not reducer.feed(makeBins(0, -10, -20)));
+    PLOTTERS_TEST_TRUE(reducer.feed(makeBins(10, -10, -30)));
+    PLOTTERS_TEST_CLOSE(reducer.row()[0], 10*std::log10((1.0+10.0)/2), 1e-4);
+    PLOTTERS_TEST_CLOSE(reducer.row()[1], -10, 1e-4);
+    PLOTTERS_TEST_CLOSE(reducer.row()[2], 10*std::log10((0.01+0.001)/2), 1e-4);
+}
+
+static void testPeak(void)
+{
+    //the spectrum with the strongest bin is kept as a whole
+    SpectrogramRowReducer reducer;
+    reducer.setMode("PEAK");
+    reducer.setNumPerRow(3);
+    PLOTTERS_TEST_TRUE(not reducer.feed(makeBins(-10, -10, -10)));
+    PLOTTERS_TEST_TRUE(not reducer.feed(makeBins(-60, -3, -60)));
+    PLOTTERS_TEST_TRUE(reducer.feed(makeBins(-5, -5, -5)));
+    PLOTTERS_TEST_CLOSE(reducer.row()[0], -60, 0.0);
+    PLOTTERS_TEST_CLOSE(reducer.row()[1], -3, 0.0);
+}
+
+static void testSizeChange(void)
+{
+    //a spectrum of a different size restarts the row
+    SpectrogramRowReducer reducer;
+    reducer.setNumPerRow(2);
+    PLOTTERS_TEST_TRUE(not reducer.feed(makeBins(0, 0, 0)));
+    PLOTTERS_TEST_TRUE(not reducer.feed(std::valarray<float>(-10.0f, 4)));
+    PLOTTERS_TEST_TRUE(reducer.feed(std::valarray<float>(-20.0f, 4)));
+    PLOTTERS_TEST_TRUE(reducer.row().size() == 4);
+    PLOTTERS_TEST_CLOSE(reducer.row()[0], -10, 0.0);
+}
+
+static void testEmpty(void)
+{
+    //empty spectrums never start or complete a row
+    SpectrogramRowReducer reducer;
+    PLOTTERS_TEST_TRUE(not reducer.feed(std::valarray<float>()));
+    reducer.setMode("PEAK");
+    reducer.setNumPerRow(2);
+    PLOTTERS_TEST_TRUE(not reducer.feed(std::valarray<float>()));
+    PLOTTERS_TEST_TRUE(not reducer.feed(makeBins(-1, -2, -3)));
+    PLOTTERS_TEST_TRUE(not reducer.feed(std::valarray<float>()));
+    PLOTTERS_TEST_TRUE(reducer.feed(makeBins(-4, -5, -6)));
+    PLOTTERS_TEST_CLOSE(reducer.row()[0], -1, 0.0);
+}
+
+static void testBadMode(void)
+{
+    SpectrogramRowReducer reducer;
+    bool thrown = false;
+    try
+    {
+        reducer.setMode("MEDIAN");
+    }
+    catch (const Pothos::InvalidArgumentException &)
+    {
+        thrown = true;
+    }
+    PLOTTERS_TEST_TRUE(thrown);
+}
+
+int main(void)
+{
+    testPassThrough();
+    testMax();
+    testMean();
+    testPeak();
+    testSizeChange();
+    testEmpty();
+    testBadMode();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PlottersTest.hpp"
+#include "PothosSweepStitcher.hpp"
+
+//a frame of N bins in FFT order from -fs/2, bin k is set to offset + k
+static std::valarray<float> makeFrame(const size_t N, const float offset)
+{
+    std::valarray<float> bins(N);
+    for (size_t k = 0; k < N; k++) bins[k] = offset + float(k);
+    return bins;
+}
+
+static void testEmpty(void)
+{
+    PothosSweepStitcher sweep;
+    double lo = 0.0, hi = 0.0;
+    PLOTTERS_TEST_TRUE(not sweep.extent(lo, hi));
+    PLOTTERS_TEST_TRUE(sweep.numBins() == 0);
+    const auto out = sweep.resample(0.0, 1.0, 4, -1000.0f);
+    PLOTTERS_TEST_TRUE(out.size() == 4);
+    PLOTTERS_TEST_CLOSE(out.max(), -1000.0, 0.0);
+
+    //frames that are too small or without a rate are ignored
+    sweep.update(std::valarray<float>(1), 100.0, 10.0, 0.0);
+    sweep.update(makeFrame(10, 0), 100.0, 0.0, 0.0);
+    PLOTTERS_TEST_TRUE(sweep.numSegments() == 0);
+}
+
+static void testTrim(void)
+{
+    //the trim removes a fraction of the band from each edge
+    PothosSweepStitcher sweep;
+    sweep.setTrim(0.1);
+    sweep.update(makeFrame(10, 0), 100.0, 10.0, 0.0);
+    double lo = 0.0, hi = 0.0;
+    PLOTTERS_TEST_TRUE(sweep.extent(lo, hi));
+    PLOTTERS_TEST_CLOSE(lo, 96.0, 1e-9);
+    PLOTTERS_TEST_CLOSE(hi, 104.0, 1e-9);
+    PLOTTERS_TEST_TRUE(sweep.numBins() == 8);
+}
+
+static void testNativeResample(void)
+{
+    //resampling onto the bin centers of a single segment returns its bins,
+    //bin k of a segment is at center + (k - N/2)*fs/N
+    PothosSweepStitcher sweep;
+    sweep.setTrim(0.0);
+    sweep.update(makeFrame(10, -50), 100.0, 10.0, 0.0);
+    const auto out = sweep.resample(95.0, 104.0, 10, -1000.0f);
+    for (size_t k = 0; k < 10; k++) PLOTTERS_TEST_CLOSE(out[k], -50.0+k, 0.0);
+
+    //outside of the segment is filled
+    const auto wide = sweep.resample(85.0, 114.0, 30, -1000.0f);
+    PLOTTERS_TEST_CLOSE(wide[0], -1000.0, 0.0);
+    PLOTTERS_TEST_CLOSE(wide[10], -50.0, 0.0);
+    PLOTTERS_TEST_CLOSE(wide[29], -1000.0, 0.0);
+}
+
+static void testDecimatedResample(void)
+{
+    //several input bins under an output bin are reduced with max
+    PothosSweepStitcher sweep;
+    sweep.setTrim(0.0);
+    sweep.update(makeFrame(16, 0), 0.0, 16.0, 0.0);
+    const auto out = sweep.resample(-7.5, 6.5, 8, -1000.0f);
+    PLOTTERS_TEST_CLOSE(out[0], 1.0, 0.0);
+    PLOTTERS_TEST_CLOSE(out[7], 15.0, 0.0);
+}
+
+static void testOverlap(void)
+{
+    //overlapping segments are split halfway through the overlap
+    PothosSweepStitcher sweep;
+    sweep.setTrim(0.0);
+    sweep.update(makeFrame(10, 0), 100.0, 10.0, 0.0);
+    sweep.update(makeFrame(10, 100), 106.0, 10.0, 0.0);
+    double lo = 0.0, hi = 0.0;
+    PLOTTERS_TEST_TRUE(sweep.extent(lo, hi));
+    PLOTTERS_TEST_CLOSE(lo, 95.0, 1e-9);
+    PLOTTERS_TEST_CLOSE(hi, 111.0, 1e-9);
+    PLOTTERS_TEST_TRUE(sweep.numBins() == 16);
+
+    //the split is at 103: below it from the first segment, above from the second
+    const auto out = sweep.resample(102.0, 104.0, 3, -1000.0f);
+    PLOTTERS_TEST_CLOSE(out[0], 7.0, 0.0);
+    PLOTTERS_TEST_CLOSE(out[2], 103.0, 0.0);
+}
+
+static void testPasses(void)
+{
+    //a frame for a center that was already updated starts a new pass
+    PothosSweepStitcher sweep;
+    PLOTTERS_TEST_TRUE(not sweep.isNewPass(100.0));
+    sweep.update(makeFrame(10, 0), 100.0, 10.0, 0.0);
+    sweep.update(makeFrame(10, 0), 110.0, 10.0, 0.1);
+    PLOTTERS_TEST_TRUE(sweep.isNewPass(100.0));
+    PLOTTERS_TEST_TRUE(not sweep.isNewPass(120.0));
+    sweep.update(makeFrame(10, 10), 100.0, 10.0, 0.2);
+    PLOTTERS_TEST_TRUE(not sweep.isNewPass(110.0));
+    PLOTTERS_TEST_TRUE(sweep.numSegments() == 2);
+
+    //the new frame replaces the old frame for the same center
+    sweep.setTrim(0.0);
+    PLOTTERS_TEST_CLOSE(sweep.resample(95.0, 95.0, 1, -1000.0f)[0], 10.0, 0.0);
+}
+
+static void testMaxAge(void)
+{
+    //segments that are not updated within the max age are dropped
+    PothosSweepStitcher sweep;
+    sweep.setMaxAge(1.0);
+    sweep.update(makeFrame(10, 0), 100.0, 10.0, 0.0);
+    sweep.update(makeFrame(10, 0), 110.0, 10.0, 0.5);
+    PLOTTERS_TEST_TRUE(sweep.numSegments() == 2);
+    sweep.update(makeFrame(10, 0), 110.0, 10.0, 1.5);
+    PLOTTERS_TEST_TRUE(sweep.numSegments() == 1);
+
+    //the remaining segment is the one that was updated
+    double lo = 0.0, hi = 0.0;
+    PLOTTERS_TEST_TRUE(sweep.extent(lo, hi));
+    PLOTTERS_TEST_CLOSE((lo+hi)/2, 110.0, 1e-9);
+}
+
+int main(void)
+{
+    testEmpty();
+    testTrim();
+    testNativeResample();
+    testDecimatedResample();
+    testOverlap();
+    testPasses();
+    testMaxAge();
+    return EXIT_SUCCESS;
+}